@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "list.hpp"
+#include "queue.hpp"
+
+static size_t MAX_THREADS = std::max(1u, std::thread::hardware_concurrency());
+static size_t OPS = 200000;
+static size_t REPS = 5;
+static const size_t WARMUP = 1;
+static const size_t STRING_LENGTH = 32;
+static const size_t BATCH = 256;
+
+struct Stats {
+    double min;
+    double p50;
+    double max;
+};
+
+// Runs job(thread index) on threads threads at once, REPS times.
+static Stats measure(size_t threads, const std::function<void(size_t)>& job,
+        const std::function<void(void)>& reset) {
+    auto run = [threads, &job]() {
+        std::vector<std::thread> pool;
+        for (size_t t = 0; t < threads; ++t) {
+            pool.emplace_back(job, t);
+        }
+        for (std::thread& t : pool) {
+            t.join();
+        }
+    };
+    for (size_t i = 0; i < WARMUP; ++i) {
+        run();
+        reset();
+    }
+    std::vector<double> times;
+    for (size_t i = 0; i < REPS; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double>(end - start).count());
+        reset();
+    }
+    std::sort(times.begin(), times.end());
+    return Stats{times.front(), times[times.size() / 2], times.back()};
+}
+
+static void report(const char* type, const char* reclaim, const char* op,
+        size_t threads, const Stats& st, size_t ops) {
+    std::printf("%-8s %-4s %-12s %3zu  %9.3f %9.3f %9.3f  %9.2f\n", type,
+        reclaim, op, threads, st.min * 1e3, st.p50 * 1e3, st.max * 1e3,
+        static_cast<double>(ops) / st.p50 * 1e-6);
+}
+
+static void popOrSkip(size_t n, const std::function<void(void)>& pop) {
+    for (size_t i = 0; i < n; ++i) {
+        try {
+            pop();
+        } catch (const std::out_of_range&) {
+        }
+    }
+}
+
+// Every thread pushes OPS values, then the list is cleared untimed.
+template <class List, class Push>
+static void benchPush(const char* type, const char* reclaim, const char* op,
+        Push push) {
+    for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        List l;
+        Stats st = measure(threads, [&l, &push](size_t) {
+            for (size_t i = 0; i < OPS; ++i) {
+                push(&l, i);
+            }
+        }, [&l]() { l.clear(); });
+        report(type, reclaim, op, threads, st, threads * OPS);
+    }
+}
+
+// Every thread alternates a push and a pop, so nodes are reclaimed and
+// reused all the time.
+template <class List, class Push, class Pop>
+static void benchChurn(const char* type, const char* reclaim, const char* op,
+        Push push, Pop pop) {
+    for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        List l;
+        Stats st = measure(threads, [&l, &push, &pop](size_t) {
+            for (size_t i = 0; i < OPS; ++i) {
+                push(&l, i);
+                pop(&l);
+            }
+        }, [&l]() { l.clear(); });
+        report(type, reclaim, op, threads, st, 2 * threads * OPS);
+    }
+}
+
+// Thread 0 walks the list over and over while the others churn it as in
+// benchChurn; only the churn is counted.
+template <class List>
+static void benchWalk(const char* reclaim) {
+    for (size_t threads = 2; threads <= std::max<size_t>(MAX_THREADS, 2);
+            threads *= 2) {
+        List l;
+        for (size_t i = 0; i < BATCH; ++i) {
+            l.push_front(static_cast<int>(i));
+        }
+        std::atomic<size_t> done(0);
+        Stats st = measure(threads, [&l, &done, threads](size_t t) {
+            if (t == 0) {
+                size_t seen = 0;
+                while (done.load(std::memory_order_relaxed) < threads - 1) {
+                    for (int v : l) {
+                        seen += static_cast<size_t>(v) & 1;
+                    }
+                }
+                static_cast<void>(seen);
+                return;
+            }
+            int out = 0;
+            for (size_t i = 0; i < OPS; ++i) {
+                l.push_front(static_cast<int>(i));
+                l.try_pop_front(out);
+            }
+            done.fetch_add(1);
+        }, [&done]() { done.store(0); });
+        report("int", reclaim, "churn+walk", threads, st,
+            2 * (threads - 1) * OPS);
+    }
+}
+
+// Every thread pushes OPS values BATCH at a time, either one by one or with
+// push_range, and then drains the list with pop_front or pop_all.
+template <class List>
+static void benchBatch(const char* reclaim, const char* op, bool bulk) {
+    for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        List l;
+        Stats st = measure(threads, [&l, bulk](size_t) {
+            std::vector<int> values(BATCH);
+            for (size_t i = 0; i < OPS; i += BATCH) {
+                for (size_t j = 0; j < BATCH; ++j) {
+                    values[j] = static_cast<int>(i + j);
+                }
+                if (bulk) {
+                    l.push_range(values.begin(), values.end());
+                    typename List::batch taken = l.pop_all();
+                } else {
+                    for (int v : values) {
+                        l.push_front(v);
+                    }
+                    popOrSkip(BATCH, [&l]() { l.pop_front(); });
+                }
+            }
+        }, [&l]() { l.clear(); });
+        report("int", reclaim, op, threads, st, 2 * threads * OPS);
+    }
+}
+
+// What list::queue is compared with.
+template <class T>
+class locked_deque {
+    public:
+        void push_back(const T& val) {
+            std::lock_guard<std::mutex> guard(lock_);
+            values_.push_back(val);
+        }
+
+        bool try_pop_front(T& out) {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (values_.empty()) {
+                return false;
+            }
+            out = std::move(values_.front());
+            values_.pop_front();
+            return true;
+        }
+
+    private:
+        std::mutex lock_;
+        std::deque<T> values_;
+};
+
+// Pushes and pops alternate in every thread, or, with split, half of the
+// threads only push and the other half pop until they have taken as many.
+template <class Queue>
+static void benchQueue(const char* type, const char* reclaim, bool split) {
+    for (size_t threads = split ? 2 : 1; threads <= MAX_THREADS;
+            threads *= 2) {
+        Queue q;
+        Stats st = measure(threads, [&q, split](size_t t) {
+            int out = 0;
+            for (size_t i = 0; i < OPS; ++i) {
+                if (!split || t % 2 == 0) {
+                    q.push_back(static_cast<int>(i));
+                }
+                if (!split) {
+                    q.try_pop_front(out);
+                } else if (t % 2 == 1) {
+                    while (!q.try_pop_front(out)) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        }, []() {});
+        report(type, reclaim, split ? "prod/cons" : "push+pop", threads, st,
+            split ? threads * OPS : 2 * threads * OPS);
+    }
+}
+
+// The list workloads with one reclamation policy.
+template <class Reclaimer>
+static void benchList(const char* reclaim) {
+    typedef list::list<int, list::node_pool, Reclaimer> ints;
+    typedef list::list<std::string, list::node_pool, Reclaimer> strings;
+    typedef list::list<std::unique_ptr<int>, list::node_pool, Reclaimer>
+        uniques;
+
+    benchPush<ints>("int", reclaim, "push", [](ints* l, size_t i) {
+        l->push_front(static_cast<int>(i));
+    });
+    benchPush<strings>("string", reclaim, "push", [](strings* l, size_t) {
+        l->push_front(std::string(STRING_LENGTH, 'x'));
+    });
+    benchPush<strings>("string", reclaim, "emplace", [](strings* l, size_t) {
+        l->emplace_front(STRING_LENGTH, 'x');
+    });
+    benchPush<uniques>("unique", reclaim, "emplace", [](uniques* l, size_t i) {
+        l->emplace_front(new int(static_cast<int>(i)));
+    });
+
+    auto push = [](ints* l, size_t i) {
+        l->push_front(static_cast<int>(i));
+    };
+    benchChurn<ints>("int", reclaim, "push+pop", push, [](ints* l) {
+        popOrSkip(1, [l]() { l->pop_front(); });
+    });
+    benchChurn<ints>("int", reclaim, "push+try_pop", push, [](ints* l) {
+        int out = 0;
+        l->try_pop_front(out);
+    });
+    benchChurn<strings>("string", reclaim, "emplace+pop",
+        [](strings* l, size_t) {
+            l->emplace_front(STRING_LENGTH, 'x');
+        },
+        [](strings* l) {
+            std::string out;
+            l->try_pop_front(out);
+        });
+    benchBatch<ints>(reclaim, "batch-single", false);
+    benchBatch<ints>(reclaim, "batch-bulk", true);
+    benchWalk<ints>(reclaim);
+}
+
+// The churn with size() kept in one shared counter instead of shards.
+static void benchExactSize() {
+    typedef list::list<int, list::node_pool, list::hazard_pointers,
+        list::exact_counter> ints;
+
+    benchChurn<ints>("int/x", "hp", "push+try_pop",
+        [](ints* l, size_t i) {
+            l->push_front(static_cast<int>(i));
+        },
+        [](ints* l) {
+            int out = 0;
+            l->try_pop_front(out);
+        });
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        MAX_THREADS = std::stoull(argv[1]);
+    }
+    if (argc > 2) {
+        OPS = std::stoull(argv[2]);
+    }
+    if (argc > 3) {
+        REPS = std::max<size_t>(1, std::stoull(argv[3]));
+    }
+
+    std::printf("%-8s %-4s %-12s %3s  %9s %9s %9s  %9s\n", "type", "mem",
+        "op", "thr", "min,ms", "p50,ms", "max,ms", "Mops/s");
+
+    benchList<list::hazard_pointers>("hp");
+    benchList<list::interval_epochs>("ibr");
+    benchExactSize();
+
+    benchQueue<list::queue<int>>("queue", "hp", false);
+    benchQueue<locked_deque<int>>("deque", "-", false);
+    benchQueue<list::queue<int>>("queue", "hp", true);
+    benchQueue<locked_deque<int>>("deque", "-", true);
+
+    return 0;
+}
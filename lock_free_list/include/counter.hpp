@@ -0,0 +1,86 @@
+#ifndef LOCK_FREE_LIST_INCLUDE_COUNTER_HPP_
+#define LOCK_FREE_LIST_INCLUDE_COUNTER_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+#include "hazard.hpp"
+
+namespace list {
+
+//
+// Size counters
+//
+// A list keeps its element count in a Counter providing
+//
+//     void add(ptrdiff_t n);  // n elements pushed, or -n popped
+//     size_t load() const;
+//
+// add() may be called from any thread at the same time as load().
+//
+
+// One shard per thread, each changed only by its thread with a plain load
+// and store, so pushes and pops touch no shared cache line for the count.
+// load() sums the shards: while other threads push and pop it may be a
+// value the count never had, but it is exact once they stop. A shard can
+// go negative when a thread pops what others pushed, and so can the sum
+// for a moment, when it reads a pop's shard after the pop but the pushing
+// shard before its push; load() clamps it to zero. The shard of an
+// exiting thread keeps its value for the next one.
+class striped_counter {
+    public:
+        striped_counter() {}
+
+        striped_counter(const striped_counter& other) = delete;
+        striped_counter& operator=(const striped_counter& other) = delete;
+
+        void add(ptrdiff_t n) {
+            std::atomic<ptrdiff_t>& value = slots_.mine().value;
+            value.store(value.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+        }
+
+        size_t load() const {
+            ptrdiff_t sum = 0;
+            for (size_t i = 0; i < slots_.used(); ++i) {
+                sum += slots_[i].value.load(std::memory_order_relaxed);
+            }
+            return sum < 0 ? 0 : static_cast<size_t>(sum);
+        }
+
+    private:
+        struct alignas(CACHE_LINE) slot {
+            std::atomic<bool> claimed{false};
+            std::atomic<ptrdiff_t> value{0};
+
+            void release() {}
+        };
+
+        __thread_registry<slot> slots_;
+};
+
+// One shared count updated by every push and pop: load() is always a value
+// the count had, at the price of a contended cache line on each operation.
+class exact_counter {
+    public:
+        exact_counter() : value_(0) {}
+
+        exact_counter(const exact_counter& other) = delete;
+        exact_counter& operator=(const exact_counter& other) = delete;
+
+        void add(ptrdiff_t n) {
+            value_.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        size_t load() const {
+            ptrdiff_t value = value_.load(std::memory_order_relaxed);
+            return value < 0 ? 0 : static_cast<size_t>(value);
+        }
+
+    private:
+        alignas(CACHE_LINE) std::atomic<ptrdiff_t> value_;
+};
+
+}  // namespace list
+
+#endif  // LOCK_FREE_LIST_INCLUDE_COUNTER_HPP_
@@ -0,0 +1,148 @@
+#ifndef LOCK_FREE_LIST_INCLUDE_ELIMINATION_HPP_
+#define LOCK_FREE_LIST_INCLUDE_ELIMINATION_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "hazard.hpp"
+
+namespace list {
+
+// Slots a push and a pop may meet in.
+const size_t ELIMINATION_SLOTS = 32;
+
+// Times a push looks at its slot for a pop before taking its node back.
+const size_t ELIMINATION_SPINS = 128;
+
+inline uint32_t __elimination_random() {
+    static thread_local uint32_t state = static_cast<uint32_t>(
+        std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Lets a push and a pop that both lost a CAS on the head cancel out without
+// touching it. The push parks its node in a random slot for a while and a
+// pop passing by takes it. Each slot goes
+//
+//     empty -> node (push offers) -> taken (pop takes) -> empty (push sees)
+//
+// or back from node to empty when the push gives up, and only the offering
+// push empties a slot, so no node can reappear in a slot while its push is
+// still looking. Slots are picked among the first range(); the range grows
+// when threads collide in the slots and shrinks when offers time out.
+template <class Node>
+class elimination_array {
+    public:
+        explicit elimination_array(size_t capacity = ELIMINATION_SLOTS) :
+                capacity_(std::max<size_t>(capacity, 1)), range_(1),
+                slots_(nullptr) {}
+
+        elimination_array(const elimination_array& other) = delete;
+        elimination_array& operator=(const elimination_array& other) = delete;
+
+        ~elimination_array() {
+            delete[] slots_.load(std::memory_order_relaxed);
+        }
+
+        size_t range() const {
+            return range_.load(std::memory_order_relaxed);
+        }
+
+        // True when a pop took p; otherwise p is still the caller's.
+        bool offer(Node* p) {
+            std::atomic<Node*>& cell = pick_();
+            Node* expected = nullptr;
+            if (!cell.compare_exchange_strong(expected, p,
+                    std::memory_order_release, std::memory_order_relaxed)) {
+                grow_();
+                return false;
+            }
+            for (size_t i = 0; i < ELIMINATION_SPINS; ++i) {
+                if (cell.load(std::memory_order_acquire) != p) {
+                    cell.store(nullptr, std::memory_order_release);
+                    grow_();
+                    return true;
+                }
+            }
+            expected = p;
+            if (cell.compare_exchange_strong(expected, nullptr,
+                    std::memory_order_acquire)) {
+                shrink_();
+                return false;
+            }
+            cell.store(nullptr, std::memory_order_release);
+            return true;
+        }
+
+        // A node some push is offering, now the caller's, or nullptr.
+        Node* take() {
+            std::atomic<Node*>& cell = pick_();
+            Node* p = cell.load(std::memory_order_acquire);
+            if (p == nullptr) {
+                return nullptr;
+            }
+            if (p == taken_() || !cell.compare_exchange_strong(p, taken_(),
+                    std::memory_order_acquire, std::memory_order_relaxed)) {
+                grow_();
+                return nullptr;
+            }
+            return p;
+        }
+
+    private:
+        struct alignas(CACHE_LINE) slot {
+            std::atomic<Node*> node{nullptr};
+        };
+
+        size_t capacity_;
+        std::atomic<size_t> range_;
+
+        // Allocated by the first push or pop that loses a CAS, so a list
+        // that never sees contention does not pay for it.
+        std::atomic<slot*> slots_;
+
+        static Node* taken_() {
+            return reinterpret_cast<Node*>(uintptr_t(1));
+        }
+
+        std::atomic<Node*>& pick_() {
+            slot* slots = slots_.load(std::memory_order_acquire);
+            if (slots == nullptr) {
+                std::unique_ptr<slot[]> fresh(new slot[capacity_]);
+                if (slots_.compare_exchange_strong(slots, fresh.get(),
+                        std::memory_order_acq_rel)) {
+                    slots = fresh.release();
+                }
+            }
+            size_t range = range_.load(std::memory_order_relaxed);
+            return slots[__elimination_random() % range].node;
+        }
+
+        void grow_() {
+            size_t range = range_.load(std::memory_order_relaxed);
+            if (range < capacity_) {
+                range_.compare_exchange_weak(range, range + 1,
+                    std::memory_order_relaxed);
+            }
+        }
+
+        void shrink_() {
+            size_t range = range_.load(std::memory_order_relaxed);
+            if (range > 1) {
+                range_.compare_exchange_weak(range, range - 1,
+                    std::memory_order_relaxed);
+            }
+        }
+};
+
+}  // namespace list
+
+#endif  // LOCK_FREE_LIST_INCLUDE_ELIMINATION_HPP_
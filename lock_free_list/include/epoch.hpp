@@ -0,0 +1,264 @@
+#ifndef LOCK_FREE_LIST_INCLUDE_EPOCH_HPP_
+#define LOCK_FREE_LIST_INCLUDE_EPOCH_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "hazard.hpp"
+
+namespace list {
+
+// Nodes born on a thread between two advances of the global epoch.
+const size_t EPOCH_FREQUENCY = 64;
+
+// Retire lists are scanned once they reach this size.
+const size_t EPOCH_SCAN = 128;
+
+// What epoch_domain needs in every node: the epoch it was allocated in.
+struct __epoch_header {
+    uint64_t birth_epoch;
+};
+
+// One epoch for every domain, so that the stamps of nodes moved from one
+// list to another stay comparable.
+inline std::atomic<uint64_t>& __epoch_clock() {
+    static std::atomic<uint64_t> epoch(1);
+    return epoch;
+}
+
+// Interval-based reclamation (two global epochs). A thread inside an
+// operation reserves the interval of epochs from its enter() to the latest
+// protect(); a retired node remembers the epochs it was born and retired
+// in, and is freed once its lifetime overlaps no reservation. Reads cost a
+// load of the global epoch instead of a hazard pointer store and fence,
+// and retire lists are scanned in batches against one pair of epochs per
+// thread. Unlike plain epochs a stalled thread only holds back nodes that
+// were alive during its interval, so the memory it pins is bounded.
+//
+// Pointers must be read through protect() between enter() and leave();
+// set() and clear() have nothing to do. push()/pop() open and close an
+// operation for callers that hold nodes across calls.
+template <class Node>
+class epoch_domain {
+    public:
+        typedef void (*free_function)(Node*, void*);
+
+        epoch_domain() = delete;
+
+        epoch_domain(size_t per_thread, free_function free_node,
+                void* context) :
+                    perThread_(std::max<size_t>(per_thread, 1)),
+                    epoch_(__epoch_clock()),
+                    asymmetric_(__asymmetric_fences()),
+                    free_(free_node), context_(context) {}
+
+        epoch_domain(const epoch_domain& other) = delete;
+        epoch_domain& operator=(const epoch_domain& other) = delete;
+
+        ~epoch_domain() {
+            slots_.close();
+            for (size_t i = 0; i < slots_.used(); ++i) {
+                for (const retired_node& r : slots_[i].retired) {
+                    free_(r.node, context_);
+                }
+            }
+        }
+
+        size_t per_thread() const {
+            return perThread_;
+        }
+
+        void attach() {
+            slots_.mine();
+        }
+
+        uint64_t epoch() const {
+            return epoch_.load(std::memory_order_relaxed);
+        }
+
+        // Operations nest; only the outermost ones reserve and release.
+        void enter() {
+            slot& me = slots_.mine();
+            if (me.nesting++ == 0) {
+                uint64_t e = epoch_.load(std::memory_order_acquire);
+                me.upper.store(e, std::memory_order_relaxed);
+                __publish(&me.lower, e, asymmetric_);
+            }
+        }
+
+        void leave() {
+            slot& me = slots_.mine();
+            if (me.nesting != 0 && --me.nesting == 0) {
+                me.lower.store(IDLE, std::memory_order_release);
+                me.upper.store(IDLE, std::memory_order_release);
+            }
+        }
+
+        void born(Node* p) {
+            slot& me = slots_.mine();
+            p->birth_epoch = epoch_.load(std::memory_order_relaxed);
+            if (++me.births % EPOCH_FREQUENCY == 0) {
+                epoch_.fetch_add(1, std::memory_order_acq_rel);
+            }
+        }
+
+        // Reads src and extends this thread's reservation up to the
+        // current epoch, so that whatever was read cannot be freed.
+        Node* protect(size_t, const std::atomic<Node*>& src) {
+            slot& me = slots_.mine();
+            uint64_t upper = me.upper.load(std::memory_order_relaxed);
+            for (;;) {
+                Node* p = src.load(std::memory_order_acquire);
+                uint64_t e = epoch_.load(std::memory_order_acquire);
+                if (e == upper) {
+                    return p;
+                }
+                __publish(&me.upper, e, asymmetric_);
+                upper = e;
+            }
+        }
+
+        void set(size_t, Node*) {}
+
+        void clear(size_t) {}
+
+        size_t depth() {
+            return slots_.mine().depth;
+        }
+
+        bool push(Node*) {
+            slot& me = slots_.mine();
+            if (me.depth == perThread_) {
+                return false;
+            }
+            ++me.depth;
+            enter();
+            return true;
+        }
+
+        void pop() {
+            slot& me = slots_.mine();
+            if (me.depth != 0) {
+                --me.depth;
+                leave();
+            }
+        }
+
+        void retire(Node* p) {
+            slot& me = slots_.mine();
+            me.retired.push_back(retired_node{p, p->birth_epoch,
+                epoch_.load(std::memory_order_acquire)});
+            if (me.retired.size() >= std::max(EPOCH_SCAN, me.scanAt)) {
+                scan_(&me);
+            }
+        }
+
+        // A pinned traversal is one long operation: it reserves from
+        // pin() on, and each load_pinned() extends the reservation.
+        void pin() {
+            enter();
+        }
+
+        void unpin() {
+            leave();
+        }
+
+        Node* load_pinned(const std::atomic<Node*>& src) {
+            return protect(0, src);
+        }
+
+        void scan() {
+            scan_(&slots_.mine());
+        }
+
+    private:
+        static constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+        struct retired_node {
+            Node* node;
+            uint64_t birth;
+            uint64_t retire;
+        };
+
+        struct alignas(CACHE_LINE) slot {
+            std::atomic<bool> claimed{false};
+            std::atomic<uint64_t> lower{IDLE};
+            std::atomic<uint64_t> upper{IDLE};
+            size_t nesting = 0;
+            size_t depth = 0;
+            size_t births = 0;
+            size_t scanAt = 0;
+            std::vector<retired_node> retired;
+            std::vector<std::pair<uint64_t, uint64_t>> scratch;
+
+            void release() {
+                lower.store(IDLE, std::memory_order_release);
+                upper.store(IDLE, std::memory_order_release);
+                nesting = 0;
+                depth = 0;
+            }
+        };
+
+        size_t perThread_;
+        std::atomic<uint64_t>& epoch_;
+        bool asymmetric_;
+        free_function free_;
+        void* context_;
+        __thread_registry<slot> slots_;
+
+        // Lower bounds are read before upper ones: a thread that leaves
+        // and enters again in between only makes the interval wider. What
+        // a scan keeps is not scanned again before the list doubles.
+        void scan_(slot* me) {
+            __heavy_fence(asymmetric_);
+            std::vector<std::pair<uint64_t, uint64_t>>& reserved =
+                me->scratch;
+            reserved.clear();
+            size_t used = slots_.used();
+            for (size_t i = 0; i < used; ++i) {
+                uint64_t lower = slots_[i].lower.load(
+                    std::memory_order_acquire);
+                if (lower == IDLE) {
+                    continue;
+                }
+                uint64_t upper = slots_[i].upper.load(
+                    std::memory_order_acquire);
+                reserved.emplace_back(lower, upper);
+            }
+
+            size_t kept = 0;
+            for (const retired_node& r : me->retired) {
+                bool busy = false;
+                for (const std::pair<uint64_t, uint64_t>& res : reserved) {
+                    if (r.birth <= res.second && r.retire >= res.first) {
+                        busy = true;
+                        break;
+                    }
+                }
+                if (busy) {
+                    me->retired[kept++] = r;
+                } else {
+                    free_(r.node, context_);
+                }
+            }
+            me->retired.resize(kept);
+            me->scanAt = 2 * kept;
+        }
+};
+
+// Reclamation policy of list; see hazard_pointers.
+struct interval_epochs {
+    typedef __epoch_header node_header;
+
+    template <class Node>
+    using domain = epoch_domain<Node>;
+};
+
+}  // namespace list
+
+#endif  // LOCK_FREE_LIST_INCLUDE_EPOCH_HPP_
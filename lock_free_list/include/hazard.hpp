@@ -0,0 +1,532 @@
+#ifndef LOCK_FREE_LIST_INCLUDE_HAZARD_HPP_
+#define LOCK_FREE_LIST_INCLUDE_HAZARD_HPP_
+
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace list {
+
+const size_t CACHE_LINE = 64;
+
+// Retire lists are scanned once they reach this size at least.
+const size_t HAZARD_SCAN_MIN = 64;
+
+// The same when every scan pays for a membarrier(2); see __heavy_fence.
+const size_t HAZARD_SCAN_FENCED = 256;
+
+// Registry segments; segment k holds 2^k slots.
+const size_t REGISTRY_SEGMENTS = 32;
+
+const std::length_error ExceptSlots(
+    "list: Too many threads for this list"
+);
+
+//
+// Per-thread slots
+//
+
+// Slots the current thread holds, one per registry it has used. Slots whose
+// registry is still alive are given back when the thread exits.
+struct __slot_cache {
+    struct entry {
+        uint64_t registry;
+        void* slot;
+        std::weak_ptr<void> alive;
+        void (*release)(void*, void*);
+    };
+
+    std::vector<entry> entries;
+
+    // The entry found last, checked before the others; a thread mostly
+    // asks the same registry several times in a row.
+    uint64_t last_registry = 0;
+    void* last_slot = nullptr;
+
+    ~__slot_cache() {
+        for (entry& e : entries) {
+            std::shared_ptr<void> alive = e.alive.lock();
+            if (alive) {
+                e.release(alive.get(), e.slot);
+            }
+        }
+    }
+};
+
+inline __slot_cache& __thread_slots() {
+    static thread_local __slot_cache cache;
+    return cache;
+}
+
+// Never reused, so a stale cache entry cannot match a new registry that
+// happens to live at the same address.
+inline uint64_t __next_registry_id() {
+    static std::atomic<uint64_t> next(1);
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Cache-line aligned slots, one per thread using the owner. A thread claims
+// the first free slot with a CAS on first use and releases it when it
+// exits; what the slot holds stays for the next thread that claims it.
+// Slot needs an std::atomic<bool> claimed member and a release() member
+// called on thread exit.
+//
+// Slots are allocated on demand in segments of 1, 2, 4, ... slots, so an
+// unused registry holds none, any number of threads fits and a slot never
+// moves. init runs on every slot of a new segment before other threads
+// can see it. The segments, and whatever init hangs off their slots, are
+// owned by a state that exiting threads keep alive while they release
+// their slot. The owner calls close() before it tears down anything
+// release() touches; from then on exiting threads leave their slots alone.
+template <class Slot>
+class __thread_registry {
+    public:
+        typedef std::function<void(Slot&)> init_function;
+
+        explicit __thread_registry(init_function init = nullptr) :
+                id_(__next_registry_id()), init_(std::move(init)), used_(0),
+                state_(std::make_shared<state>()) {}
+
+        __thread_registry(const __thread_registry& other) = delete;
+        __thread_registry& operator=(const __thread_registry& other) = delete;
+
+        ~__thread_registry() {
+            close();
+        }
+
+        Slot& mine() {
+            __slot_cache& cache = __thread_slots();
+            if (cache.last_registry == id_) {
+                return *static_cast<Slot*>(cache.last_slot);
+            }
+            for (const __slot_cache::entry& e : cache.entries) {
+                if (e.registry == id_) {
+                    cache.last_registry = id_;
+                    cache.last_slot = e.slot;
+                    return *static_cast<Slot*>(e.slot);
+                }
+            }
+            return claim_(&cache);
+        }
+
+        // Every slot a thread has ever held is below used().
+        size_t used() const {
+            return used_.load(std::memory_order_acquire);
+        }
+
+        // Slots below used() only.
+        Slot& operator[](size_t i) {
+            return *at_(i);
+        }
+
+        const Slot& operator[](size_t i) const {
+            return *at_(i);
+        }
+
+        // Waits for exiting threads that are releasing a slot and stops
+        // later ones from doing so.
+        void close() {
+            std::lock_guard<std::mutex> guard(state_->lock);
+            state_->closed = true;
+        }
+
+    private:
+        struct state {
+            std::atomic<Slot*> segments[REGISTRY_SEGMENTS] = {};
+            std::mutex lock;
+            bool closed = false;
+
+            ~state() {
+                for (std::atomic<Slot*>& segment : segments) {
+                    delete[] segment.load(std::memory_order_relaxed);
+                }
+            }
+        };
+
+        uint64_t id_;
+        init_function init_;
+        std::atomic<size_t> used_;
+        std::shared_ptr<state> state_;
+
+        static size_t segment_(size_t i) {
+            return static_cast<size_t>(63 - __builtin_clzll(i + 1));
+        }
+
+        Slot* at_(size_t i) const {
+            size_t k = segment_(i);
+            return state_->segments[k].load(std::memory_order_acquire) +
+                (i + 1 - (size_t(1) << k));
+        }
+
+        // The segment holding slot i, allocated if nobody has yet.
+        Slot* segment_of_(size_t i) {
+            size_t k = segment_(i);
+            if (k >= REGISTRY_SEGMENTS) {
+                throw ExceptSlots;
+            }
+            std::atomic<Slot*>& where = state_->segments[k];
+            Slot* segment = where.load(std::memory_order_acquire);
+            if (segment == nullptr) {
+                std::unique_ptr<Slot[]> fresh(new Slot[size_t(1) << k]);
+                if (init_) {
+                    for (size_t j = 0; j < (size_t(1) << k); ++j) {
+                        init_(fresh[j]);
+                    }
+                }
+                if (where.compare_exchange_strong(segment, fresh.get(),
+                        std::memory_order_acq_rel)) {
+                    segment = fresh.release();
+                }
+            }
+            return segment + (i + 1 - (size_t(1) << k));
+        }
+
+        Slot& claim_(__slot_cache* cache) {
+            for (size_t i = 0;; ++i) {
+                Slot& slot = *segment_of_(i);
+                bool expected = false;
+                if (slot.claimed.load(std::memory_order_relaxed) ||
+                        !slot.claimed.compare_exchange_strong(expected, true,
+                            std::memory_order_acquire)) {
+                    continue;
+                }
+                size_t used = used_.load(std::memory_order_relaxed);
+                while (used < i + 1 && !used_.compare_exchange_weak(used,
+                        i + 1, std::memory_order_release)) {}
+                // Anything this thread publishes in the slot from now on is
+                // ordered after the new used_ for a scanner's fence.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                cache->entries.erase(std::remove_if(cache->entries.begin(),
+                    cache->entries.end(), [](const __slot_cache::entry& e) {
+                        return e.alive.expired();
+                    }), cache->entries.end());
+                cache->entries.push_back(__slot_cache::entry{id_, &slot,
+                    std::weak_ptr<void>(state_), &release_});
+                return slot;
+            }
+        }
+
+        static void release_(void* owner, void* slot) {
+            state* st = static_cast<state*>(owner);
+            std::lock_guard<std::mutex> guard(st->lock);
+            if (st->closed) {
+                return;
+            }
+            Slot* s = static_cast<Slot*>(slot);
+            s->release();
+            s->claimed.store(false, std::memory_order_release);
+        }
+};
+
+//
+// Asymmetric fences
+//
+// A thread publishing a protection has to order that store before its next
+// load, and a scanner has to see the store. Instead of a full fence on every
+// publication, readers only stop the compiler and scanners pay with
+// membarrier(2), which runs a full fence on every CPU that is running a
+// thread of the process. Without kernel support publications fall back to
+// sequentially consistent stores, and so do builds for ThreadSanitizer,
+// which cannot see the ordering membarrier gives.
+//
+
+inline bool __asymmetric_fences() {
+#if defined(__SANITIZE_THREAD__)
+    return false;
+#endif
+    static const bool ready = ::syscall(__NR_membarrier,
+        MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+    return ready;
+}
+
+template <class T>
+inline void __publish(std::atomic<T>* where, T what, bool asymmetric) {
+    if (asymmetric) {
+        where->store(what, std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    } else {
+        where->store(what, std::memory_order_seq_cst);
+    }
+}
+
+// Before a scan reads what other threads have published.
+inline void __heavy_fence(bool asymmetric) {
+    if (asymmetric) {
+        ::syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+//
+// Hazard pointers
+//
+
+// Hazard pointers of each thread in cache lines of its own slot, padded to
+// whole lines, and retire lists kept in the thread slots. A scan reads the
+// lines of every slot in use instead of walking per-thread containers.
+// Retired nodes are handed to free_node(node, context).
+template <class Node>
+class hazard_domain {
+    public:
+        typedef void (*free_function)(Node*, void*);
+
+        hazard_domain() = delete;
+
+        hazard_domain(size_t per_thread, free_function free_node,
+                void* context) :
+                    perThread_(std::max<size_t>(per_thread, 1)),
+                    stride_((perThread_ + PER_LINE - 1) / PER_LINE),
+                    asymmetric_(__asymmetric_fences()), era_(0),
+                    free_(free_node), context_(context),
+                    slots_([count = perThread_, stride = stride_](slot& s) {
+                        s.lines.reset(new line[stride]);
+                        s.hazards = s.lines[0].ptr;
+                        s.count = count;
+                    }) {}
+
+        hazard_domain(const hazard_domain& other) = delete;
+        hazard_domain& operator=(const hazard_domain& other) = delete;
+
+        ~hazard_domain() {
+            slots_.close();
+            for (size_t i = 0; i < slots_.used(); ++i) {
+                for (const retired_node& r : slots_[i].retired) {
+                    free_(r.node, context_);
+                }
+            }
+        }
+
+        size_t per_thread() const {
+            return perThread_;
+        }
+
+        void attach() {
+            slots_.mine();
+        }
+
+        // Hazard pointers protect nodes one by one, so operations need no
+        // bracketing and nodes no birth stamp.
+        void enter() {}
+
+        void leave() {}
+
+        void born(Node*) {}
+
+        // Publishes the current value of src as hazard i of this thread
+        // and returns it once it is known to have still been in src after
+        // the publication.
+        Node* protect(size_t i, const std::atomic<Node*>& src) {
+            std::atomic<Node*>* hazard = slots_.mine().hazards + i;
+            Node* p = src.load(std::memory_order_relaxed);
+            for (;;) {
+                __publish(hazard, p, asymmetric_);
+                Node* again = src.load(std::memory_order_acquire);
+                if (again == p) {
+                    return p;
+                }
+                p = again;
+            }
+        }
+
+        void set(size_t i, Node* p) {
+            __publish(slots_.mine().hazards + i, p, asymmetric_);
+        }
+
+        void clear(size_t i) {
+            slots_.mine().hazards[i].store(nullptr, std::memory_order_release);
+        }
+
+        // Hazards this thread has set through push()/pop().
+        size_t depth() {
+            return slots_.mine().depth;
+        }
+
+        // Stack-like use of the hazards, for callers that do not track
+        // indices. Returns false when all per_thread() are in use.
+        bool push(Node* p) {
+            slot& me = slots_.mine();
+            if (me.depth == perThread_) {
+                return false;
+            }
+            __publish(me.hazards + me.depth++, p, asymmetric_);
+            return true;
+        }
+
+        void pop() {
+            slot& me = slots_.mine();
+            if (me.depth != 0) {
+                me.hazards[--me.depth].store(nullptr,
+                    std::memory_order_release);
+            }
+        }
+
+        void retire(Node* p) {
+            slot& me = slots_.mine();
+            me.retired.push_back(retired_node{p, UNPINNED});
+            if (me.retired.size() >= std::max(threshold_(), me.scanAt)) {
+                scan_(&me);
+            }
+        }
+
+        // Pinning keeps every node this thread reaches from then on alive
+        // until it unpins, without a hazard per node. Each scan starts a
+        // new era and stamps what it keeps with it; a pinned thread has
+        // seen the eras before its pin end, so it cannot reach what was
+        // retired in them, and only newer nodes are held back for it.
+        // Nodes read through load_pinned() need no other protection. Pins
+        // nest.
+        void pin() {
+            slot& me = slots_.mine();
+            if (me.pins++ == 0) {
+                __publish(&me.pinned, era_.load(std::memory_order_acquire),
+                    asymmetric_);
+            }
+        }
+
+        void unpin() {
+            slot& me = slots_.mine();
+            if (me.pins != 0 && --me.pins == 0) {
+                me.pinned.store(UNPINNED, std::memory_order_release);
+            }
+        }
+
+        Node* load_pinned(const std::atomic<Node*>& src) {
+            return src.load(std::memory_order_acquire);
+        }
+
+        void scan() {
+            scan_(&slots_.mine());
+        }
+
+    private:
+        static constexpr size_t PER_LINE = CACHE_LINE / sizeof(void*);
+
+        static constexpr uint64_t UNPINNED =
+            std::numeric_limits<uint64_t>::max();
+
+        // A node and the era of the first scan that saw it retired.
+        struct retired_node {
+            Node* node;
+            uint64_t era;
+        };
+
+        struct alignas(CACHE_LINE) line {
+            std::atomic<Node*> ptr[PER_LINE];
+
+            line() {
+                for (size_t i = 0; i < PER_LINE; ++i) {
+                    ptr[i].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        struct alignas(CACHE_LINE) slot {
+            std::atomic<bool> claimed{false};
+            std::unique_ptr<line[]> lines;
+            std::atomic<Node*>* hazards = nullptr;
+            std::atomic<uint64_t> pinned{UNPINNED};
+            size_t count = 0;
+            size_t depth = 0;
+            size_t pins = 0;
+            size_t scanAt = 0;
+            std::vector<retired_node> retired;
+            std::vector<Node*> scratch;
+
+            void release() {
+                for (size_t i = 0; i < count; ++i) {
+                    hazards[i].store(nullptr, std::memory_order_release);
+                }
+                pinned.store(UNPINNED, std::memory_order_release);
+                depth = 0;
+                pins = 0;
+            }
+        };
+
+        size_t perThread_;
+        size_t stride_;
+        bool asymmetric_;
+        std::atomic<uint64_t> era_;
+        free_function free_;
+        void* context_;
+        __thread_registry<slot> slots_;
+
+        size_t threshold_() const {
+            return std::max(asymmetric_ ? HAZARD_SCAN_FENCED : HAZARD_SCAN_MIN,
+                2 * slots_.used() * perThread_);
+        }
+
+        // What a scan keeps is not scanned again before the retire list
+        // doubles, so a long pin costs no more than a scan per retire.
+        void scan_(slot* me) {
+            uint64_t era = era_.fetch_add(1, std::memory_order_acq_rel);
+            __heavy_fence(asymmetric_);
+            size_t used = slots_.used();
+            uint64_t oldest = UNPINNED;
+            for (size_t i = 0; i < used; ++i) {
+                oldest = std::min(oldest,
+                    slots_[i].pinned.load(std::memory_order_acquire));
+            }
+            std::vector<Node*>& hazards = me->scratch;
+            hazards.clear();
+            for (size_t i = 0; i < used; ++i) {
+                const line* lines = slots_[i].lines.get();
+                for (size_t l = 0; l < stride_; ++l) {
+                    for (size_t j = 0; j < PER_LINE; ++j) {
+                        Node* p = lines[l].ptr[j].load(
+                            std::memory_order_acquire);
+                        if (p != nullptr) {
+                            hazards.push_back(p);
+                        }
+                    }
+                }
+            }
+            std::sort(hazards.begin(), hazards.end());
+
+            size_t kept = 0;
+            for (retired_node& r : me->retired) {
+                r.era = std::min(r.era, era);
+                if (r.era >= oldest || std::binary_search(hazards.begin(),
+                        hazards.end(), r.node)) {
+                    me->retired[kept++] = r;
+                } else {
+                    free_(r.node, context_);
+                }
+            }
+            me->retired.resize(kept);
+            me->scanAt = 2 * kept;
+        }
+};
+
+//
+// Reclamation policies
+//
+// A list is parametrized by a policy providing the header its nodes need
+// and the domain that reclaims them. A domain provides attach(), enter()
+// and leave() around operations, born() for new nodes, protect(), set()
+// and clear() of numbered per-thread protections, push() and pop() of
+// stacked ones, pin(), unpin() and load_pinned() for traversals, retire()
+// and scan(), as hazard_domain does.
+//
+
+struct hazard_pointers {
+    struct node_header {};
+
+    template <class Node>
+    using domain = hazard_domain<Node>;
+};
+
+}  // namespace list
+
+#endif  // LOCK_FREE_LIST_INCLUDE_HAZARD_HPP_
@@ -3,10 +3,13 @@
 
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <initializer_list>
+#include <iostream>
 #include <iterator>
-#include <map>
 #include <memory>
+#include <new>
 #include <sstream>
 #include <stdexcept>
 #include <thread>
@@ -14,6 +17,12 @@
 #include <utility>
 #include <vector>
 
+#include "counter.hpp"
+#include "elimination.hpp"
+#include "epoch.hpp"
+#include "hazard.hpp"
+#include "pool.hpp"
+
 namespace list {
 
 const std::out_of_range ExceptEmptyList(
@@ -32,13 +41,40 @@ const std::invalid_argument ExceptNullPtr(
     "list: Null pointer argument"
 );
 
-template <class T>
-struct __list_node {
-    T value;
+// The value lives in raw storage so that it is constructed in place from
+// the arguments of emplace_front. The tail sentinel never constructs it;
+// the head sentinel holds a default-constructed value, when T has one, for
+// swap_first(). Header is whatever the reclamation policy keeps in each
+// node.
+template <class T, class Header = hazard_pointers::node_header>
+struct __list_node : Header {
+    alignas(T) unsigned char storage[sizeof(T)];
     std::atomic<__list_node*> next;
+
+    T& value() {
+        return *std::launder(reinterpret_cast<T*>(storage));
+    }
+
+    const T& value() const {
+        return *std::launder(reinterpret_cast<const T*>(storage));
+    }
 };
 
-template <class T>
+// Iterators of a list pin its reclamation domain for as long as they
+// exist, so they can walk the list while other threads push and pop. The
+// walk is weakly consistent: it sees the elements that stay in the list
+// all along, may or may not see the ones pushed or popped meanwhile, and
+// never reaches freed memory, nor a value try_pop_front() is taking.
+//
+// An iterator is a pin owned by the thread that made it: copies made on
+// that thread pin again, but neither it nor a copy may be handed to, or
+// copied from, another thread. Under hazard_pointers a pin holds back
+// every node retired while it lasts, so a walker that never lets go of
+// its iterator keeps them all and memory grows without bound;
+// interval_epochs bounds what it keeps. Iterators of a batch, and end(),
+// pin nothing.
+template <class T, class Node = __list_node<T>,
+        class Domain = hazard_domain<Node>>
 class __list_iterator {
     public:
         typedef T value_type;
@@ -47,11 +83,43 @@ class __list_iterator {
 
         __list_iterator() = delete;
 
-        __list_iterator(__list_node<T>* node, __list_node<T>* tail) :
-                node_(node), tail_(tail) {}
+        __list_iterator(Node* node, Node* tail) :
+                node_(node), tail_(tail), domain_(nullptr) {}
+
+        // Takes over a pin the caller holds on domain.
+        __list_iterator(Node* node, Node* tail, Domain* domain) :
+                node_(node), tail_(tail), domain_(domain) {}
+
+        __list_iterator(const __list_iterator& other) :
+                node_(other.node_), tail_(other.tail_),
+                domain_(other.domain_) {
+            if (domain_ != nullptr) {
+                domain_->pin();
+            }
+        }
+
+        __list_iterator& operator=(const __list_iterator& other) {
+            if (other.domain_ != nullptr) {
+                other.domain_->pin();
+            }
+            if (domain_ != nullptr) {
+                domain_->unpin();
+            }
+            node_ = other.node_;
+            tail_ = other.tail_;
+            domain_ = other.domain_;
+            return *this;
+        }
+
+        ~__list_iterator() {
+            if (domain_ != nullptr) {
+                domain_->unpin();
+            }
+        }
 
-        __list_iterator operator++() {
-            node_ = node_->next;
+        __list_iterator& operator++() {
+            node_ = domain_ != nullptr ? domain_->load_pinned(node_->next) :
+                node_->next.load(std::memory_order_acquire);
             return *this;
         }
 
@@ -67,19 +135,21 @@ class __list_iterator {
             if (node_ == tail_) {
                 throw ExceptIterator;
             }
-            return node_->value;
+            return node_->value();
         }
 
-        __list_node<T>* getNode() {
+        Node* getNode() {
             return node_;
         }
 
     private:
-        __list_node<T>* node_;
-        __list_node<T>* tail_;
+        Node* node_;
+        Node* tail_;
+        Domain* domain_;
 };
 
-template <class T>
+template <class T, class Node = __list_node<T>,
+        class Domain = hazard_domain<Node>>
 class __list_const_iterator {
     public:
         typedef T value_type;
@@ -88,11 +158,43 @@ class __list_const_iterator {
 
         __list_const_iterator() = delete;
 
-        __list_const_iterator(__list_node<T>* node, __list_node<T>* tail) :
-                node_(node), tail_(tail) {}
+        __list_const_iterator(Node* node, Node* tail) :
+                node_(node), tail_(tail), domain_(nullptr) {}
 
-        __list_const_iterator operator++() {
-            node_ = node_->next;
+        // Takes over a pin the caller holds on domain.
+        __list_const_iterator(Node* node, Node* tail, Domain* domain) :
+                node_(node), tail_(tail), domain_(domain) {}
+
+        __list_const_iterator(const __list_const_iterator& other) :
+                node_(other.node_), tail_(other.tail_),
+                domain_(other.domain_) {
+            if (domain_ != nullptr) {
+                domain_->pin();
+            }
+        }
+
+        __list_const_iterator& operator=(const __list_const_iterator& other) {
+            if (other.domain_ != nullptr) {
+                other.domain_->pin();
+            }
+            if (domain_ != nullptr) {
+                domain_->unpin();
+            }
+            node_ = other.node_;
+            tail_ = other.tail_;
+            domain_ = other.domain_;
+            return *this;
+        }
+
+        ~__list_const_iterator() {
+            if (domain_ != nullptr) {
+                domain_->unpin();
+            }
+        }
+
+        __list_const_iterator& operator++() {
+            node_ = domain_ != nullptr ? domain_->load_pinned(node_->next) :
+                node_->next.load(std::memory_order_acquire);
             return *this;
         }
 
@@ -108,19 +210,24 @@ class __list_const_iterator {
             if (node_ == tail_) {
                 throw ExceptIterator;
             }
-            return node_->value;
+            return node_->value();
         }
 
-        const __list_node<T>* getNode() {
+        const Node* getNode() {
             return node_;
         }
 
     private:
-        __list_node<T>* node_;
-        __list_node<T>* tail_;
+        Node* node_;
+        Node* tail_;
+        Domain* domain_;
 };
 
-template <class T>
+// Allocator<node> provides the node storage (see pool.hpp), Reclaimer,
+// hazard_pointers or interval_epochs, decides when retired nodes go back
+// to it, and Counter, striped_counter or exact_counter, keeps size().
+template <class T, template <class> class Allocator = node_pool,
+        class Reclaimer = hazard_pointers, class Counter = striped_counter>
 class list {
     public:
         typedef T value_type;
@@ -134,95 +241,168 @@ class list {
         typedef size_t              size_type;
         typedef ptrdiff_t           difference_type;
 
-        typedef __list_iterator<value_type>             iterator;
-        typedef __list_const_iterator<value_type>       const_iterator;
-
     private:
-        typedef __list_node<value_type> node;
+        typedef __list_node<value_type, typename Reclaimer::node_header> node;
 
     public:
+        typedef Allocator<node> allocator_type;
+        typedef typename Reclaimer::template domain<node> domain_type;
+
+        typedef __list_iterator<value_type, node, domain_type>   iterator;
+        typedef __list_const_iterator<value_type, node, domain_type>
+            const_iterator;
+
+        // Nodes taken out of a list by pop_all(), in list order, for
+        // iteration by one thread. They are retired through the list when
+        // the batch is destroyed, so threads still reading them stay safe;
+        // a batch must not outlive its list.
+        class batch {
+            public:
+                batch(batch&& x) noexcept : owner_(x.owner_),
+                        first_(x.first_), end_(x.end_), size_(x.size_) {
+                    x.first_ = x.end_;
+                    x.size_ = 0;
+                }
+
+                batch& operator=(batch&& x) noexcept {
+                    if (&x != this) {
+                        release_();
+                        owner_ = x.owner_;
+                        first_ = x.first_;
+                        end_ = x.end_;
+                        size_ = x.size_;
+                        x.first_ = x.end_;
+                        x.size_ = 0;
+                    }
+                    return *this;
+                }
+
+                batch(const batch& other) = delete;
+                batch& operator=(const batch& other) = delete;
+
+                ~batch() {
+                    release_();
+                }
+
+                iterator begin() {
+                    return iterator(first_, end_);
+                }
+
+                const_iterator begin() const {
+                    return const_iterator(first_, end_);
+                }
+
+                iterator end() {
+                    return iterator(end_, end_);
+                }
+
+                const_iterator end() const {
+                    return const_iterator(end_, end_);
+                }
+
+                bool empty() const {
+                    return first_ == end_;
+                }
+
+                size_type size() const {
+                    return size_;
+                }
+
+            private:
+                list* owner_;
+                node* first_;
+                node* end_;
+                size_type size_;
+
+                batch(list* owner, node* first, node* end, size_type size) :
+                    owner_(owner), first_(first), end_(end), size_(size) {}
+
+                void release_() noexcept {
+                    node* curr = first_;
+                    while (curr != end_) {
+                        node* next = curr->next;
+                        owner_->retire_node_(curr);
+                        curr = next;
+                    }
+                    first_ = end_;
+                    size_ = 0;
+                }
+
+                friend class list;
+        };
+
         //
         // Constructors
         //
 
         explicit list(size_t hazard_ptr_allowed = 1) :
-                size_(0), num_threads_(1),
-                hazard_ptr_allowed_(hazard_ptr_allowed) {
+                hazard_ptr_allowed_(hazard_ptr_allowed),
+                alloc_(std::make_shared<allocator_type>()),
+                domain_(hazard_ptr_allowed + HAZARDS, &free_node_,
+                    alloc_.get()) {
             init_();
         }
 
         explicit list(size_type n, const value_type& val,
                 size_t hazard_ptr_allowed = 1) :
-                    size_(n), num_threads_(1),
-                    hazard_ptr_allowed_(hazard_ptr_allowed) {
+                    hazard_ptr_allowed_(hazard_ptr_allowed),
+                    alloc_(std::make_shared<allocator_type>()),
+                    domain_(hazard_ptr_allowed + HAZARDS, &free_node_,
+                        alloc_.get()) {
             init_();
+            node* last = head_;
             for (size_type i = 0; i < n; ++i) {
-                node* curr = new node;
-                curr->next = tail_;
-                curr->value = val;
+                last = link_after_(last, val);
             }
         }
 
         template <class InputIterator>
         list(InputIterator first, InputIterator last,
                 size_t hazard_ptr_allowed = 1,
-                typename std::enable_if
-                <std::__is_input_iterator<InputIterator>::value>::type* = 0) :
-                    num_threads_(1),
-                    hazard_ptr_allowed_(hazard_ptr_allowed) {
+                typename std::enable_if<std::is_convertible<
+                    typename std::iterator_traits<InputIterator>::
+                        iterator_category,
+                    std::input_iterator_tag>::value>::type* = 0) :
+                    hazard_ptr_allowed_(hazard_ptr_allowed),
+                    alloc_(std::make_shared<allocator_type>()),
+                    domain_(hazard_ptr_allowed + HAZARDS, &free_node_,
+                        alloc_.get()) {
             init_();
-            size_t i = 0;
-            for (InputIterator it = first; it != last; ++it) {
-                node* curr = new node;
-                curr->next = tail_;
-                curr->value = *it;
-                ++i;
-            }
-            size_ = i;
+            append_(first, last);
         }
 
-        list(const list& x) {
+        list(const list& x) : hazard_ptr_allowed_(x.hazard_ptr_allowed_),
+                alloc_(std::make_shared<allocator_type>()),
+                domain_(x.hazard_ptr_allowed_ + HAZARDS, &free_node_,
+                    alloc_.get()) {
             init_();
-            size_t i = 0;
-            node* start = x.head_->next;
-            for (node* next = start; next != x.tail_; next = next->next) {
-                node* curr = new node;
-                curr->next = tail_;
-                curr->value = next->value;
-                ++i;
-            }
-            size_ = i;
-            num_threads_ = x.num_threads_;
-            hazard_ptr_allowed_ = x.hazard_ptr_allowed_;
-            hazard_ptrs_ = x.hazard_ptrs_;
-            retire_ = x.retire_;
-        }
-
-        list(list&& x) {
+            append_(x.begin(), x.end());
+        }
+
+        // Takes x's nodes and leaves x empty. Both lists share the
+        // allocator from then on, since the nodes came from it. Nodes x
+        // has already retired stay with x and are freed with it.
+        list(list&& x) : hazard_ptr_allowed_(x.hazard_ptr_allowed_),
+                alloc_(x.alloc_),
+                domain_(x.hazard_ptr_allowed_ + HAZARDS, &free_node_,
+                    alloc_.get()) {
             head_ = x.head_;
             tail_ = x.tail_;
-            size_.store(x.size_);
-            num_threads_ = x.num_threads_;
-            hazard_ptr_allowed_ = x.hazard_ptr_allowed_;
-            hazard_ptrs_ = x.hazard_ptrs_;
-            retire_ = x.retire_;
+            ptrdiff_t n = static_cast<ptrdiff_t>(x.size_.load());
+            size_.add(n);
+            x.init_();
+            x.size_.add(-n);
         }
 
         list(std::initializer_list<value_type> il,
                 size_t num_threads = 1, size_t hazard_ptr_allowed = 1) :
-                    num_threads_(num_threads),
-                    hazard_ptr_allowed_(hazard_ptr_allowed) {
+                    hazard_ptr_allowed_(hazard_ptr_allowed),
+                    alloc_(std::make_shared<allocator_type>()),
+                    domain_(hazard_ptr_allowed + HAZARDS, &free_node_,
+                        alloc_.get()) {
+            static_cast<void>(num_threads);
             init_();
-            auto first = il.begin();
-            auto last = il.end();
-            size_t i = 0;
-            for (auto it = first; it != last; ++it) {
-                node* curr = new node;
-                curr->next = tail_;
-                curr->value = *it;
-                ++i;
-            }
-            size_ = i;
+            append_(il.begin(), il.end());
         }
 
         //
@@ -230,51 +410,42 @@ class list {
         //
 
         list& operator=(const list& x) {
-            clear();
-
-            size_t i = 0;
-            node* start = x.head_->next;
-            for (node* next = start; next != x.tail_; next = next->next) {
-                node* curr = new node;
-                curr->next = tail_;
-                curr->value = next->value;
-                ++i;
+            if (&x != this) {
+                clear();
+                append_(x.begin(), x.end());
             }
-            size_ = i;
-            num_threads_ = x.num_threads_;
-            hazard_ptr_allowed_ = x.hazard_ptr_allowed_;
-
             return *this;
         }
 
+        // Swaps the node chains when both lists share an allocator; this
+        // list's old nodes then go out with x. Otherwise the values are
+        // moved into nodes of this list's allocator.
         list& operator=(list&& x) {
+            if (&x == this) {
+                return *this;
+            }
+            if (alloc_ == x.alloc_) {
+                std::swap(head_, x.head_);
+                std::swap(tail_, x.tail_);
+                ptrdiff_t diff = static_cast<ptrdiff_t>(x.size_.load()) -
+                    static_cast<ptrdiff_t>(size_.load());
+                size_.add(diff);
+                x.size_.add(-diff);
+                return *this;
+            }
             clear();
-
-            head_ = x.head_;
-            tail_ = x.tail_;
-            size_ = x.size_;
-            num_threads_ = x.num_threads_;
-            hazard_ptr_allowed_ = x.hazard_ptr_allowed_;
-            hazard_ptrs_ = x.hazard_ptrs_;
-            retire_ = x.retire_;
-
+            node* prev = head_;
+            for (node* curr = x.head_->next; curr != x.tail_;
+                    curr = curr->next) {
+                prev = link_after_(prev, std::move(curr->value()));
+            }
+            x.clear();
             return *this;
         }
 
         list& operator=(std::initializer_list<value_type> il) {
             clear();
-
-            auto first = il.begin();
-            auto last = il.end();
-            size_t i = 0;
-            for (auto it = first; it != last; ++it) {
-                node* curr = new node;
-                curr->next = tail_;
-                curr->value = *it;
-                ++i;
-            }
-            size_ = i;
-
+            append_(il.begin(), il.end());
             return *this;
         }
 
@@ -283,12 +454,17 @@ class list {
         //
 
         ~list() {
-            node* prev = head_;
-            for (node* next = head_; next != nullptr; next = next->next) {
-                if (next != prev) {
-                    delete prev;
+            node* curr = head_;
+            while (curr != nullptr) {
+                node* next = curr->next;
+                if (curr == head_) {
+                    free_head_(curr);
+                } else if (curr == tail_) {
+                    free_sentinel_(curr);
+                } else {
+                    free_node_(curr, alloc_.get());
                 }
-                prev = next;
+                curr = next;
             }
         }
 
@@ -298,31 +474,29 @@ class list {
 
         void print() {
             std::stringstream s;
-            for (node* curr = head_; curr != nullptr; curr = curr->next) {
-                if (curr == head_) {
-                    s << "head: (" << curr->value << ") ";
-                    continue;
-                }
-                if (curr == tail_) {
-                    s << "tail: (" << curr->value << ") ";
-                    continue;
-                }
-                s << curr->value << " ";
+            s << "head: ";
+            for (const value_type& val : *this) {
+                s << val << " ";
             }
+            s << "tail";
             s << std::endl;
             std::cout << s.str();
         }
 
         iterator begin() {
-            return iterator(head_->next, tail_);
+            domain_.pin();
+            return iterator(domain_.load_pinned(head_->next), tail_,
+                &domain_);
         }
 
         const_iterator begin() const {
-            return const_iterator(head_->next, tail_);
+            domain_.pin();
+            return const_iterator(domain_.load_pinned(head_->next), tail_,
+                &domain_);
         }
 
-        const_iterator cbegin() const noexcept {
-            return const_iterator(head_->next, tail_);
+        const_iterator cbegin() const {
+            return begin();
         }
 
         iterator end() {
@@ -344,8 +518,15 @@ class list {
             return head_->next == tail_;
         }
 
+        // Approximate while other threads push or pop; see Counter.
         inline size_type size() const {
-            return size_;
+            return size_.load();
+        }
+
+        // Counters of the node allocator, shared with lists moved from
+        // this one.
+        pool_stats stats() const {
+            return alloc_->stats();
         }
 
         //
@@ -356,14 +537,14 @@ class list {
             if (empty()) {
                 throw ExceptEmptyList;
             }
-            return head_->next.load(std::memory_order_relaxed)->value;
+            return head_->next.load(std::memory_order_relaxed)->value();
         }
 
         inline const_reference front() const {
             if (empty()) {
                 throw ExceptEmptyList;
             }
-            return head_->next.load(std::memory_order_relaxed)->value;
+            return head_->next.load(std::memory_order_relaxed)->value();
         }
 
         //
@@ -371,100 +552,151 @@ class list {
         //
 
         void push_front(const value_type& val) {
-            std::stringstream s;
-            s << "Push(" << val << ")"<< std::endl;
-            // std::cout << s.str();
-
-            node* new_node = new node;
-            new_node->value = val;
-
-            bool done = false;
-            while (!done) {
-                node* next = head_->next;
-                new_node->next = next;
-                done = head_->next.compare_exchange_weak(next, new_node,
-                    std::memory_order_relaxed);
-            }
-
-            size_.fetch_add(1, std::memory_order_relaxed);
+            emplace_front(val);
         }
 
         void push_front(value_type&& val) {
-            std::stringstream s;
-            s << "Push(" << val << ")"<< std::endl;
-            // std::cout << s.str();
+            emplace_front(std::move(val));
+        }
+
+        // Constructs the value in place inside the new node.
+        template <class... Args>
+        void emplace_front(Args&&... args) {
+            node* new_node = new_node_(std::forward<Args>(args)...);
+            node* next = head_->next.load(std::memory_order_relaxed);
+            new_node->next.store(next, std::memory_order_relaxed);
+            while (!head_->next.compare_exchange_weak(next, new_node,
+                    std::memory_order_release, std::memory_order_relaxed)) {
+                if (elimination_.offer(new_node)) {
+                    return;
+                }
+                new_node->next.store(next, std::memory_order_relaxed);
+            }
 
-            node* new_node = new node;
-            new_node->value = val;
+            size_.add(1);
+        }
 
-            bool done = false;
-            while (!done) {
-                node* next = head_->next;
-                new_node->next = next;
-                done = head_->next.compare_exchange_weak(next, new_node,
-                    std::memory_order_relaxed);
+        // Links the values into a private chain and publishes it with a
+        // single CAS; the list then starts with *first.
+        template <class InputIterator>
+        void push_range(InputIterator first, InputIterator last) {
+            node* chain = nullptr;
+            node* end = nullptr;
+            size_type n = 0;
+            try {
+                for (InputIterator it = first; it != last; ++it) {
+                    node* curr = new_node_(*it);
+                    curr->next.store(nullptr, std::memory_order_relaxed);
+                    if (end == nullptr) {
+                        chain = curr;
+                    } else {
+                        end->next.store(curr, std::memory_order_relaxed);
+                    }
+                    end = curr;
+                    ++n;
+                }
+            } catch (...) {
+                while (chain != nullptr) {
+                    node* next = chain->next;
+                    free_node_(chain, alloc_.get());
+                    chain = next;
+                }
+                throw;
+            }
+            if (n == 0) {
+                return;
             }
 
-            size_.fetch_add(1, std::memory_order_relaxed);
+            node* next = head_->next.load(std::memory_order_relaxed);
+            do {
+                end->next.store(next, std::memory_order_relaxed);
+            } while (!head_->next.compare_exchange_weak(next, chain,
+                std::memory_order_release, std::memory_order_relaxed));
+
+            size_.add(static_cast<ptrdiff_t>(n));
         }
 
         void pop_front() {
-            if (empty()) {
+            bool eliminated = false;
+            node* curr = pop_node_(&eliminated);
+            if (curr == nullptr) {
                 throw ExceptEmptyList;
-                return;
             }
-            node* curr = head_->next.load(std::memory_order_relaxed);
-            bool done = false;
-            while (!done) {
-                curr = head_->next.load(std::memory_order_relaxed);
-                if (curr == tail_) {
-                    throw ExceptEmptyList;
-                    return;
-                }
-                node* next = curr->next;
-                done = head_->next.compare_exchange_weak(curr, next,
-                    std::memory_order_relaxed);
+            release_popped_(curr, eliminated);
+        }
+
+        // Puts the first value into out; false when the list is empty.
+        // Iterators on other threads may still be reading a node just
+        // taken from the list, so its value is copied out; it is moved
+        // only from a node that came through the elimination array, or
+        // when value_type cannot be copied. With a move-only value_type,
+        // try_pop_front() must not run alongside iterators.
+        bool try_pop_front(value_type& out) {
+            bool eliminated = false;
+            node* curr = pop_node_(&eliminated);
+            if (curr == nullptr) {
+                return false;
             }
-            std::stringstream s;
-            s << "Pop(" << curr->value << ")"<< std::endl;
-            // std::cout << s.str();
-            size_.fetch_sub(1, std::memory_order_relaxed);
-            retire_node_(curr);
+            try {
+                take_value_(curr, eliminated, out);
+            } catch (...) {
+                release_popped_(curr, eliminated);
+                throw;
+            }
+            release_popped_(curr, eliminated);
+            return true;
         }
 
+        // Swaps the value held by the head sentinel with the first element.
+        // Needs one hazard pointer per thread; the first node is read
+        // through the protection set_hazard() would take, so it cannot be
+        // freed or reused under the swap.
         void swap_first() {
-            node* second = head_->next;
-            set_hazard(second);
+            static_assert(std::is_default_constructible<value_type>::value,
+                "list: swap_first needs a default-constructible value_type");
+            node* second = protect_hazard_(head_->next);
+            if (second == tail_) {
+                unset_hazard(second);
+                throw ExceptEmptyList;
+            }
             sleep(5);
-            std::swap(head_->value, second->value);
+            std::swap(head_->value(), second->value());
             unset_hazard(second);
         }
 
+        // Detaches every element at once.
+        batch pop_all() {
+            node* first = head_->next.exchange(tail_,
+                std::memory_order_acq_rel);
+            size_type n = 0;
+            for (node* curr = first; curr != tail_; curr = curr->next) {
+                ++n;
+            }
+            size_.add(-static_cast<ptrdiff_t>(n));
+            return batch(this, first, tail_, n);
+        }
+
         void clear() noexcept {
-            node* prev = head_->next;
-            for (node* next = prev; next != tail_; next = next->next) {
-                if (next != prev) {
-                    retire_node_(prev);
-                }
-                prev = next;
+            node* curr = head_->next.exchange(tail_);
+            ptrdiff_t n = 0;
+            while (curr != tail_) {
+                node* next = curr->next;
+                retire_node_(curr);
+                curr = next;
+                ++n;
             }
-            head_->next = tail_;
-            size_.store(0, std::memory_order_relaxed);
+            size_.add(-n);
         }
 
         //
         // Thread-safety
         //
 
+        // Claims this thread's hazard slot up front. Optional: a thread
+        // gets one on its first operation anyway, and gives it back when
+        // it exits.
         void thread_attach() {
-            attach_lock.lock();
-            std::thread::id my_id = std::this_thread::get_id();
-            hazard_ptrs_.insert(std::pair<std::thread::id, std::vector<node*>>(
-                my_id, std::vector<node*>(0)));
-            retire_.insert(std::pair<std::thread::id, std::vector<node*>>(
-                my_id, std::vector<node*>(0)));
-            ++num_threads_;
-            attach_lock.unlock();
+            domain_.attach();
         }
 
         void set_hazard(node* which) {
@@ -472,10 +704,8 @@ class list {
                 throw ExceptNullPtr;
                 return;
             }
-            std::thread::id my_id = std::this_thread::get_id();
-            if (hazard_ptrs_[my_id].size() < hazard_ptr_allowed_) {
-                hazard_ptrs_[my_id].push_back(which);
-            } else {
+            if (domain_.depth() >= hazard_ptr_allowed_ ||
+                    !domain_.push(which)) {
                 throw ExceptHazard;
             }
         }
@@ -485,68 +715,179 @@ class list {
                 throw ExceptNullPtr;
                 return;
             }
-            std::thread::id my_id = std::this_thread::get_id();
-            hazard_ptrs_[my_id].pop_back();
+            domain_.pop();
         }
 
-        void reset_num_threads() {
-            num_threads_ = 1;
-            hazard_ptrs_.clear();
-            retire_.clear();
-        }
+        // Slots are released per thread on exit, so there is nothing left
+        // to reset; kept for existing callers.
+        void reset_num_threads() {}
 
     private:
         node* head_;
         node* tail_;
-        std::atomic<size_type> size_;
+        Counter size_;
+
+        // Protections the list takes for itself, above the ones
+        // set_hazard() may use.
+        static constexpr size_t HAZARDS = 1;
 
-        size_t num_threads_;
         size_t hazard_ptr_allowed_;
-        std::map<std::thread::id, std::vector<node*>> hazard_ptrs_;
-        std::map<std::thread::id, std::vector<node*>> retire_;
-        std::mutex attach_lock;
 
-        void init_() {
-            head_ = new node;
-            tail_ = new node;
-            head_->next = tail_;
-            tail_->next = nullptr;
-            head_->value = value_type();
-            tail_->value = value_type();
+        std::shared_ptr<allocator_type> alloc_;
+        // Iterators of a const list pin it as well.
+        mutable domain_type domain_;
+        elimination_array<node> elimination_;
+
+        // Reads src into the next protection set_hazard() would take and
+        // returns it once the protection is known to cover it.
+        node* protect_hazard_(const std::atomic<node*>& src) {
+            if (domain_.depth() >= hazard_ptr_allowed_) {
+                throw ExceptHazard;
+            }
+            domain_.enter();
+            node* p = domain_.protect(domain_.depth(), src);
+            domain_.push(p);
+            domain_.leave();
+            return p;
+        }
+
+        node* new_sentinel_() {
+            return new (alloc_->allocate()) node;
         }
 
-        void scan_() {
-            // std::cout << "scan_()" << std::endl;
-            std::vector<node*> all_hazard;
-            for (auto e : hazard_ptrs_) {
-                for (auto curr : e.second) {
-                    all_hazard.push_back(curr);
+        void free_sentinel_(node* x) {
+            x->~node();
+            alloc_->deallocate(x);
+        }
+
+        node* new_head_() {
+            node* x = new_sentinel_();
+            if constexpr (std::is_default_constructible<value_type>::value) {
+                try {
+                    new (x->storage) value_type();
+                } catch (...) {
+                    free_sentinel_(x);
+                    throw;
                 }
             }
-            std::sort(all_hazard.begin(), all_hazard.end());
+            return x;
+        }
 
-            std::thread::id my_id = std::this_thread::get_id();
-            std::vector<node*> my_new_retire;
-            for (auto curr : (*retire_.find(my_id)).second) {
-                if (std::binary_search(all_hazard.begin(), all_hazard.end(),
-                        curr)) {
-                    my_new_retire.push_back(curr);
-                } else {
-                    delete curr;
+        void free_head_(node* x) {
+            if constexpr (std::is_default_constructible<value_type>::value) {
+                x->value().~value_type();
+            }
+            free_sentinel_(x);
+        }
+
+        template <class... Args>
+        node* new_node_(Args&&... args) {
+            node* x = new_sentinel_();
+            try {
+                new (x->storage) value_type(std::forward<Args>(args)...);
+            } catch (...) {
+                free_sentinel_(x);
+                throw;
+            }
+            domain_.born(x);
+            return x;
+        }
+
+        static void free_node_(node* x, void* alloc) {
+            x->value().~value_type();
+            x->~node();
+            static_cast<allocator_type*>(alloc)->deallocate(x);
+        }
+
+        template <class... Args>
+        node* link_after_(node* prev, Args&&... args) {
+            node* curr = new_node_(std::forward<Args>(args)...);
+            curr->next.store(prev->next.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            prev->next.store(curr, std::memory_order_relaxed);
+            size_.add(1);
+            return curr;
+        }
+
+        // Unlinks the first node, or takes one a concurrent push offers
+        // after losing a CAS on the head; nullptr when the list is empty.
+        // The winner of the CAS owns the node from then on and retires it
+        // itself, so the protection is dropped before returning.
+        node* pop_node_(bool* eliminated) {
+            size_t own = hazard_ptr_allowed_;
+            node* res = nullptr;
+            *eliminated = false;
+            domain_.enter();
+            for (;;) {
+                node* curr = domain_.protect(own, head_->next);
+                if (curr == tail_) {
+                    break;
+                }
+                node* next = curr->next.load(std::memory_order_acquire);
+                if (head_->next.compare_exchange_weak(curr, next,
+                        std::memory_order_acquire,
+                        std::memory_order_relaxed)) {
+                    size_.add(-1);
+                    res = curr;
+                    break;
+                }
+                res = elimination_.take();
+                if (res != nullptr) {
+                    *eliminated = true;
+                    break;
                 }
             }
-            retire_[my_id] = my_new_retire;
+            domain_.clear(own);
+            domain_.leave();
+            return res;
         }
 
-        void retire_node_(node* x) {
-            std::thread::id my_id = std::this_thread::get_id();
-            retire_[my_id].push_back(x);
+        void take_value_(node* x, bool eliminated, value_type& out) {
+            if constexpr (std::is_copy_assignable<value_type>::value) {
+                if (!eliminated) {
+                    out = x->value();
+                    return;
+                }
+            }
+            out = std::move(x->value());
+        }
+
+        // A node that came through the elimination array was never in the
+        // list, so no other thread can be reading it.
+        void release_popped_(node* x, bool eliminated) {
+            if (eliminated) {
+                free_node_(x, alloc_.get());
+            } else {
+                retire_node_(x);
+            }
+        }
 
-            if (retire_[my_id].size() >=
-                    2 * num_threads_ * hazard_ptr_allowed_) {
-                scan_();
+        template <class InputIterator>
+        void append_(InputIterator first, InputIterator last) {
+            node* prev = head_;
+            while (prev->next != tail_) {
+                prev = prev->next;
+            }
+            for (InputIterator it = first; it != last; ++it) {
+                prev = link_after_(prev, *it);
             }
         }
+
+        void init_() {
+            head_ = new_head_();
+            try {
+                tail_ = new_sentinel_();
+            } catch (...) {
+                free_head_(head_);
+                throw;
+            }
+            head_->next = tail_;
+            tail_->next = nullptr;
+        }
+
+        void retire_node_(node* x) {
+            domain_.retire(x);
+        }
 };
 
 }  // namespace list
@@ -0,0 +1,304 @@
+#ifndef LOCK_FREE_LIST_INCLUDE_ORDERED_SET_HPP_
+#define LOCK_FREE_LIST_INCLUDE_ORDERED_SET_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "hazard.hpp"
+#include "list.hpp"
+#include "pool.hpp"
+
+namespace list {
+
+//
+// Marked pointers
+//
+// The lowest bit of a node's next pointer marks the node itself as deleted;
+// nodes are at least pointer-aligned, so the bit is otherwise always zero.
+//
+
+template <class Node>
+inline Node* __marked(Node* p) {
+    return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(p) | 1u);
+}
+
+template <class Node>
+inline Node* __unmarked(Node* p) {
+    return reinterpret_cast<Node*>(
+        reinterpret_cast<uintptr_t>(p) & ~uintptr_t(1));
+}
+
+template <class Node>
+inline bool __is_marked(Node* p) {
+    return (reinterpret_cast<uintptr_t>(p) & 1u) != 0;
+}
+
+// Lock-free sorted set after Harris and Michael. erase() first marks the
+// node's next pointer, which logically deletes it and stops anyone linking
+// after it, and then unlinks it; traversals unlink the marked nodes they
+// pass and retire them into the hazard domain. A traversal holds three
+// hazard pointers: the node before the current one, the current one, and
+// the one after it. A set makes its own allocator and hazard domain, or
+// uses a shared one passed to its constructor.
+template <class T, class Compare = std::less<T>,
+        template <class> class Allocator = node_pool>
+class ordered_set {
+    public:
+        typedef T value_type;
+        typedef T key_type;
+        typedef Compare key_compare;
+
+        typedef size_t size_type;
+
+    private:
+        typedef __list_node<value_type> node;
+
+    public:
+        typedef Allocator<node> allocator_type;
+
+        // A node allocator and the hazard domain that frees into it. Sets
+        // built on the same resources share both, so that many small sets,
+        // such as the buckets of a hash table, keep one pool and one set of
+        // per-thread hazard slots between them. Nodes a set retires are
+        // freed by the domain, so the resources must outlive every set
+        // built on them.
+        struct resources {
+            resources() : domain(HAZARDS, &free_node_, &alloc) {}
+
+            resources(const resources& other) = delete;
+            resources& operator=(const resources& other) = delete;
+
+            allocator_type alloc;
+            hazard_domain<node> domain;
+        };
+
+        //
+        // Constructors
+        //
+
+        explicit ordered_set(const Compare& comp = Compare()) :
+                comp_(comp), own_(new resources), alloc_(own_->alloc),
+                domain_(own_->domain), size_(0) {
+            init_();
+        }
+
+        explicit ordered_set(resources& shared,
+                const Compare& comp = Compare()) :
+                    comp_(comp), alloc_(shared.alloc),
+                    domain_(shared.domain), size_(0) {
+            init_();
+        }
+
+        ordered_set(const ordered_set& other) = delete;
+        ordered_set& operator=(const ordered_set& other) = delete;
+
+        //
+        // Destructor
+        //
+
+        // Nodes still linked, marked or not, are freed here; unlinked ones
+        // were retired and go with the domain.
+        ~ordered_set() {
+            node* curr = __unmarked(
+                head_->next.load(std::memory_order_relaxed));
+            while (curr != nullptr) {
+                node* next = __unmarked(
+                    curr->next.load(std::memory_order_relaxed));
+                free_node_(curr, &alloc_);
+                curr = next;
+            }
+            head_->~node();
+            alloc_.deallocate(head_);
+        }
+
+        //
+        // Capacity
+        //
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        // Approximate while other threads insert or erase.
+        size_type size() const {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        // Counters of the node allocator, shared ones included.
+        pool_stats stats() const {
+            return alloc_.stats();
+        }
+
+        //
+        // Lookup
+        //
+
+        bool contains(const key_type& key) {
+            position pos;
+            bool res = find_(key, &pos);
+            release_();
+            return res;
+        }
+
+        //
+        // Modifiers
+        //
+
+        // False, with nothing inserted, when an equal key is present.
+        bool insert(const value_type& val) {
+            return emplace_node_(val);
+        }
+
+        bool insert(value_type&& val) {
+            return emplace_node_(std::move(val));
+        }
+
+        // False when no element is equal to key.
+        bool erase(const key_type& key) {
+            position pos;
+            for (;;) {
+                if (!find_(key, &pos)) {
+                    release_();
+                    return false;
+                }
+                node* next = pos.next;
+                if (!pos.curr->next.compare_exchange_weak(next,
+                        __marked(next), std::memory_order_acq_rel,
+                        std::memory_order_relaxed)) {
+                    continue;
+                }
+                node* curr = pos.curr;
+                if (pos.prev->compare_exchange_strong(curr, next,
+                        std::memory_order_acq_rel,
+                        std::memory_order_relaxed)) {
+                    domain_.retire(pos.curr);
+                } else {
+                    // Someone linked after prev or marked it; a traversal
+                    // unlinks the node on its way.
+                    find_(key, &pos);
+                }
+                release_();
+                size_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+    private:
+        // Hazard pointers per thread: next, current and previous node.
+        static constexpr size_t HAZARDS = 3;
+        static constexpr size_t HAZARD_NEXT = 0;
+        static constexpr size_t HAZARD_CURR = 1;
+        static constexpr size_t HAZARD_PREV = 2;
+
+        // Where find_ stopped: *prev == curr, curr->next == next, and curr
+        // is the first node not less than the key, or nullptr.
+        struct position {
+            std::atomic<node*>* prev;
+            node* curr;
+            node* next;
+        };
+
+        Compare comp_;
+        std::unique_ptr<resources> own_;
+        allocator_type& alloc_;
+        hazard_domain<node>& domain_;
+        node* head_;
+        alignas(CACHE_LINE) std::atomic<size_type> size_;
+
+        // True when curr holds a key equal to key. Leaves prev, curr and
+        // next protected until release_().
+        bool find_(const key_type& key, position* pos) {
+        retry:
+            std::atomic<node*>* prev = &head_->next;
+            node* curr = prev->load(std::memory_order_acquire);
+            for (;;) {
+                if (curr == nullptr) {
+                    *pos = position{prev, nullptr, nullptr};
+                    return false;
+                }
+                domain_.set(HAZARD_CURR, curr);
+                if (prev->load(std::memory_order_acquire) != curr) {
+                    goto retry;
+                }
+                node* next = curr->next.load(std::memory_order_acquire);
+                domain_.set(HAZARD_NEXT, __unmarked(next));
+                if (curr->next.load(std::memory_order_acquire) != next) {
+                    goto retry;
+                }
+                if (__is_marked(next)) {
+                    next = __unmarked(next);
+                    node* expected = curr;
+                    if (!prev->compare_exchange_strong(expected, next,
+                            std::memory_order_acq_rel,
+                            std::memory_order_relaxed)) {
+                        goto retry;
+                    }
+                    domain_.retire(curr);
+                    curr = next;
+                    continue;
+                }
+                if (!comp_(curr->value(), key)) {
+                    *pos = position{prev, curr, next};
+                    return !comp_(key, curr->value());
+                }
+                domain_.set(HAZARD_PREV, curr);
+                prev = &curr->next;
+                curr = next;
+            }
+        }
+
+        void init_() {
+            head_ = new (alloc_.allocate()) node;
+            head_->next.store(nullptr, std::memory_order_relaxed);
+        }
+
+        void release_() {
+            domain_.clear(HAZARD_NEXT);
+            domain_.clear(HAZARD_CURR);
+            domain_.clear(HAZARD_PREV);
+        }
+
+        template <class... Args>
+        bool emplace_node_(Args&&... args) {
+            node* x = new (alloc_.allocate()) node;
+            try {
+                new (x->storage) value_type(std::forward<Args>(args)...);
+            } catch (...) {
+                x->~node();
+                alloc_.deallocate(x);
+                throw;
+            }
+            position pos;
+            for (;;) {
+                if (find_(x->value(), &pos)) {
+                    release_();
+                    free_node_(x, &alloc_);
+                    return false;
+                }
+                x->next.store(pos.curr, std::memory_order_relaxed);
+                node* curr = pos.curr;
+                if (pos.prev->compare_exchange_weak(curr, x,
+                        std::memory_order_release,
+                        std::memory_order_relaxed)) {
+                    release_();
+                    size_.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+
+        static void free_node_(node* x, void* alloc) {
+            x->value().~value_type();
+            x->~node();
+            static_cast<allocator_type*>(alloc)->deallocate(x);
+        }
+};
+
+}  // namespace list
+
+#endif  // LOCK_FREE_LIST_INCLUDE_ORDERED_SET_HPP_
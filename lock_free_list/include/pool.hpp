@@ -0,0 +1,225 @@
+#ifndef LOCK_FREE_LIST_INCLUDE_POOL_HPP_
+#define LOCK_FREE_LIST_INCLUDE_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "hazard.hpp"
+
+namespace list {
+
+// Counters of a node allocator. Nodes are counted when handed out and
+// given back; bytes are what the allocator holds from the system.
+struct pool_stats {
+    size_t allocations;
+    size_t deallocations;
+    size_t bytes;
+    size_t peak_bytes;
+};
+
+// Nodes moved between a thread cache and the shared depot at a time.
+const size_t POOL_BATCH = 64;
+
+// Nodes carved from one chunk of memory.
+const size_t POOL_SLAB = 256;
+
+//
+// Allocator policies
+//
+// A list is parametrized by a template Allocator<Node> providing
+//
+//     void* allocate();          // storage for one Node
+//     void deallocate(void* p);  // storage from allocate(), Node destroyed
+//     pool_stats stats() const;
+//
+// Both may be called from any thread at the same time.
+//
+
+// Plain operator new and delete per node.
+template <class Node>
+class heap_allocator {
+    public:
+        heap_allocator() : allocations_(0), deallocations_(0), live_(0),
+                peak_(0) {}
+
+        heap_allocator(const heap_allocator& other) = delete;
+        heap_allocator& operator=(const heap_allocator& other) = delete;
+
+        void* allocate() {
+            void* p = ::operator new(sizeof(Node));
+            allocations_.fetch_add(1, std::memory_order_relaxed);
+            size_t live = live_.fetch_add(1, std::memory_order_relaxed) + 1;
+            size_t peak = peak_.load(std::memory_order_relaxed);
+            while (peak < live && !peak_.compare_exchange_weak(peak, live,
+                    std::memory_order_relaxed)) {}
+            return p;
+        }
+
+        void deallocate(void* p) {
+            ::operator delete(p);
+            deallocations_.fetch_add(1, std::memory_order_relaxed);
+            live_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        pool_stats stats() const {
+            return pool_stats{
+                allocations_.load(std::memory_order_relaxed),
+                deallocations_.load(std::memory_order_relaxed),
+                live_.load(std::memory_order_relaxed) * sizeof(Node),
+                peak_.load(std::memory_order_relaxed) * sizeof(Node)
+            };
+        }
+
+    private:
+        std::atomic<size_t> allocations_;
+        std::atomic<size_t> deallocations_;
+        std::atomic<size_t> live_;
+        std::atomic<size_t> peak_;
+};
+
+// Per-thread caches of free nodes carved from slabs. A thread allocates
+// from and frees into its own cache without synchronization; caches trade
+// batches of POOL_BATCH nodes with a shared depot when they run dry or
+// grow past two batches, and a new slab is carved only when the depot is
+// empty as well. The cache of an exiting thread goes to the depot. Slabs
+// are kept until the pool is destroyed, so bytes is also the peak.
+template <class Node>
+class node_pool {
+    public:
+        node_pool() :
+                bytes_(0), slots_([this](slot& s) { s.owner = this; }) {}
+
+        node_pool(const node_pool& other) = delete;
+        node_pool& operator=(const node_pool& other) = delete;
+
+        ~node_pool() {
+            slots_.close();
+            for (void* slab : slabs_) {
+                ::operator delete(slab, std::align_val_t(alignof(Node)));
+            }
+        }
+
+        void* allocate() {
+            slot& me = slots_.mine();
+            if (me.head == nullptr) {
+                refill_(&me);
+            }
+            block* p = me.head;
+            me.head = p->next;
+            --me.count;
+            me.allocations.store(
+                me.allocations.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+            return p;
+        }
+
+        void deallocate(void* p) {
+            slot& me = slots_.mine();
+            block* b = static_cast<block*>(p);
+            b->next = me.head;
+            me.head = b;
+            ++me.count;
+            me.deallocations.store(
+                me.deallocations.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+            if (me.count >= 2 * POOL_BATCH) {
+                spill_(&me, POOL_BATCH);
+            }
+        }
+
+        pool_stats stats() const {
+            pool_stats res{0, 0, 0, 0};
+            for (size_t i = 0; i < slots_.used(); ++i) {
+                const slot& s = slots_[i];
+                res.allocations +=
+                    s.allocations.load(std::memory_order_relaxed);
+                res.deallocations +=
+                    s.deallocations.load(std::memory_order_relaxed);
+            }
+            res.bytes = bytes_.load(std::memory_order_relaxed);
+            res.peak_bytes = res.bytes;
+            return res;
+        }
+
+    private:
+        struct block {
+            block* next;
+        };
+
+        static constexpr size_t NODE_SIZE =
+            (std::max(sizeof(Node), sizeof(block)) + alignof(Node) - 1) /
+            alignof(Node) * alignof(Node);
+
+        struct alignas(CACHE_LINE) slot {
+            std::atomic<bool> claimed{false};
+            node_pool* owner = nullptr;
+            block* head = nullptr;
+            size_t count = 0;
+            std::atomic<size_t> allocations{0};
+            std::atomic<size_t> deallocations{0};
+
+            void release() {
+                owner->spill_(this, count);
+            }
+        };
+
+        std::mutex lock_;
+        std::vector<std::pair<block*, size_t>> depot_;
+        std::vector<void*> slabs_;
+        std::atomic<size_t> bytes_;
+        __thread_registry<slot> slots_;
+
+        void refill_(slot* me) {
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                if (!depot_.empty()) {
+                    me->head = depot_.back().first;
+                    me->count = depot_.back().second;
+                    depot_.pop_back();
+                    return;
+                }
+            }
+            char* slab = static_cast<char*>(::operator new(
+                NODE_SIZE * POOL_SLAB, std::align_val_t(alignof(Node))));
+            try {
+                std::lock_guard<std::mutex> guard(lock_);
+                slabs_.push_back(slab);
+            } catch (...) {
+                ::operator delete(slab, std::align_val_t(alignof(Node)));
+                throw;
+            }
+            bytes_.fetch_add(NODE_SIZE * POOL_SLAB, std::memory_order_relaxed);
+            for (size_t i = POOL_SLAB; i-- > 0;) {
+                block* b = reinterpret_cast<block*>(slab + i * NODE_SIZE);
+                b->next = me->head;
+                me->head = b;
+            }
+            me->count = POOL_SLAB;
+        }
+
+        // Moves the first n nodes of the cache to the depot.
+        void spill_(slot* me, size_t n) {
+            if (n == 0) {
+                return;
+            }
+            block* first = me->head;
+            block* last = first;
+            for (size_t i = 1; i < n; ++i) {
+                last = last->next;
+            }
+            me->head = last->next;
+            me->count -= n;
+            last->next = nullptr;
+            std::lock_guard<std::mutex> guard(lock_);
+            depot_.emplace_back(first, n);
+        }
+};
+
+}  // namespace list
+
+#endif  // LOCK_FREE_LIST_INCLUDE_POOL_HPP_
@@ -0,0 +1,222 @@
+#ifndef LOCK_FREE_LIST_INCLUDE_QUEUE_HPP_
+#define LOCK_FREE_LIST_INCLUDE_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "hazard.hpp"
+#include "list.hpp"
+#include "pool.hpp"
+
+namespace list {
+
+// Lock-free MPMC FIFO after Michael and Scott, on the nodes, allocators and
+// hazard pointers of list. head_ points to a dummy node whose successor
+// holds the first value; the pop that moves head_ past a node becomes the
+// only reader of its value and destroys it, and the old dummy is retired.
+// Head and tail are on separate cache lines, so pushes and pops only meet
+// on an empty or nearly empty queue.
+template <class T, template <class> class Allocator = node_pool>
+class queue {
+    public:
+        typedef T value_type;
+
+        typedef value_type&         reference;
+        typedef const value_type&   const_reference;
+
+        typedef size_t              size_type;
+
+    private:
+        typedef __list_node<value_type> node;
+
+    public:
+        typedef Allocator<node> allocator_type;
+
+        //
+        // Constructors
+        //
+
+        queue() : domain_(HAZARDS, &free_node_, &alloc_), size_(0) {
+            node* dummy = new (alloc_.allocate()) node;
+            dummy->next.store(nullptr, std::memory_order_relaxed);
+            head_.store(dummy, std::memory_order_relaxed);
+            tail_.store(dummy, std::memory_order_relaxed);
+        }
+
+        queue(const queue& other) = delete;
+        queue& operator=(const queue& other) = delete;
+
+        //
+        // Destructor
+        //
+
+        ~queue() {
+            node* curr = head_.load(std::memory_order_relaxed);
+            bool dummy = true;
+            while (curr != nullptr) {
+                node* next = curr->next.load(std::memory_order_relaxed);
+                if (!dummy) {
+                    curr->value().~value_type();
+                }
+                free_node_(curr, &alloc_);
+                dummy = false;
+                curr = next;
+            }
+        }
+
+        //
+        // Capacity
+        //
+
+        // The dummy is protected as in pop_, since a concurrent pop can
+        // retire it and the pool hand it out again.
+        bool empty() const {
+            node* first;
+            node* next;
+            do {
+                first = domain_.protect(0, head_);
+                next = first->next.load(std::memory_order_acquire);
+            } while (head_.load(std::memory_order_acquire) != first);
+            domain_.clear(0);
+            return next == nullptr;
+        }
+
+        // Approximate while other threads push or pop.
+        size_type size() const {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        // Counters of the node allocator.
+        pool_stats stats() const {
+            return alloc_.stats();
+        }
+
+        //
+        // Modifiers
+        //
+
+        void push_back(const value_type& val) {
+            emplace_back(val);
+        }
+
+        void push_back(value_type&& val) {
+            emplace_back(std::move(val));
+        }
+
+        template <class... Args>
+        void emplace_back(Args&&... args) {
+            node* x = new (alloc_.allocate()) node;
+            try {
+                new (x->storage) value_type(std::forward<Args>(args)...);
+            } catch (...) {
+                free_node_(x, &alloc_);
+                throw;
+            }
+            x->next.store(nullptr, std::memory_order_relaxed);
+
+            for (;;) {
+                node* last = domain_.protect(0, tail_);
+                node* next = last->next.load(std::memory_order_acquire);
+                if (next != nullptr) {
+                    // Help a push that linked its node but has not moved
+                    // tail_ yet.
+                    tail_.compare_exchange_weak(last, next,
+                        std::memory_order_release, std::memory_order_relaxed);
+                    continue;
+                }
+                if (last->next.compare_exchange_weak(next, x,
+                        std::memory_order_release,
+                        std::memory_order_relaxed)) {
+                    tail_.compare_exchange_strong(last, x,
+                        std::memory_order_release, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            domain_.clear(0);
+            size_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void pop_front() {
+            if (!pop_([](value_type&) {})) {
+                throw ExceptEmptyList;
+            }
+        }
+
+        // Moves the first value into out; false when the queue is empty.
+        bool try_pop_front(value_type& out) {
+            return pop_([&out](value_type& val) { out = std::move(val); });
+        }
+
+    private:
+        // Hazard pointers per thread: the dummy and its successor.
+        static constexpr size_t HAZARDS = 2;
+
+        allocator_type alloc_;
+        // empty() protects the dummy as well.
+        mutable hazard_domain<node> domain_;
+
+        alignas(CACHE_LINE) std::atomic<node*> head_;
+        alignas(CACHE_LINE) std::atomic<node*> tail_;
+        alignas(CACHE_LINE) std::atomic<size_type> size_;
+
+        // Moves head_ past the dummy and hands the value of its successor,
+        // the new dummy, to take.
+        template <class F>
+        bool pop_(F take) {
+            node* first;
+            node* next;
+            for (;;) {
+                first = domain_.protect(0, head_);
+                next = domain_.protect(1, first->next);
+                if (head_.load(std::memory_order_acquire) != first) {
+                    continue;
+                }
+                if (next == nullptr) {
+                    domain_.clear(0);
+                    domain_.clear(1);
+                    return false;
+                }
+                node* last = tail_.load(std::memory_order_acquire);
+                if (first == last) {
+                    tail_.compare_exchange_weak(last, next,
+                        std::memory_order_release, std::memory_order_relaxed);
+                    continue;
+                }
+                if (head_.compare_exchange_weak(first, next,
+                        std::memory_order_acq_rel,
+                        std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            size_.fetch_sub(1, std::memory_order_relaxed);
+
+            try {
+                take(next->value());
+            } catch (...) {
+                finish_pop_(first, next);
+                throw;
+            }
+            finish_pop_(first, next);
+            return true;
+        }
+
+        void finish_pop_(node* first, node* next) {
+            next->value().~value_type();
+            domain_.clear(1);
+            domain_.clear(0);
+            domain_.retire(first);
+        }
+
+        // Values are destroyed by the pop that takes them, so a retired
+        // dummy only gives back its storage.
+        static void free_node_(node* x, void* alloc) {
+            x->~node();
+            static_cast<allocator_type*>(alloc)->deallocate(x);
+        }
+};
+
+}  // namespace list
+
+#endif  // LOCK_FREE_LIST_INCLUDE_QUEUE_HPP_
@@ -1,15 +1,23 @@
 #include <unistd.h>
+#include <atomic>
 #include <chrono>
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <sstream>
+#include <string>
 #include <thread>
 #include <vector>
 #include "list.hpp"
+#include "ordered_set.hpp"
+#include "queue.hpp"
 
 static size_t NUM_THR = 5;
 static size_t MANY = 100000;
+static const size_t QUEUE_THR = 3;
+static const size_t SET_THR = 6;
+static const int SET_KEYS = 256;
 
 void thr_job_even(size_t num, list::list<int>* numbers) {
     numbers->thread_attach();
@@ -50,6 +58,128 @@ void thr_job_ABA(list::list<int>* numbers) {
     numbers->push_front(1);
 }
 
+// Churns a short list so that every popped node comes straight back from
+// the pool; a pop acting on a stale head would lose or repeat a value.
+void thr_job_recycle(list::list<int>* numbers, std::atomic<long long>* sum) {
+    numbers->thread_attach();
+    long long popped = 0;
+    for (size_t i = 0; i < MANY / NUM_THR; ++i) {
+        numbers->push_front(static_cast<int>(i % 1000) + 1);
+        int out = 0;
+        if (numbers->try_pop_front(out)) {
+            popped += out;
+        }
+        if (i % 3 == 0 && numbers->try_pop_front(out)) {
+            popped += out;
+        }
+    }
+    sum->fetch_add(popped);
+}
+
+// Walks the list while others churn it; every value seen must be one that
+// was pushed, never the remains of a freed node.
+void thr_job_walk(list::list<int>* numbers, std::atomic<bool>* done,
+        std::atomic<bool>* garbage) {
+    numbers->thread_attach();
+    while (!done->load()) {
+        for (auto e : *numbers) {
+            if (e < 1 || e > 1000) {
+                garbage->store(true);
+            }
+        }
+    }
+}
+
+// As thr_job_recycle, with strings too long for the small-string buffer,
+// so a value popped from under a walker would be read after it is freed.
+void thr_job_recycle_text(list::list<std::string>* texts,
+        std::atomic<long long>* count) {
+    texts->thread_attach();
+    long long popped = 0;
+    for (size_t i = 0; i < MANY / NUM_THR; ++i) {
+        texts->push_front(std::string(40, static_cast<char>('a' + i % 26)));
+        std::string out;
+        if (texts->try_pop_front(out)) {
+            popped += out.size() == 40 ? 1 : 0;
+        }
+    }
+    count->fetch_add(popped);
+}
+
+// Walks the strings while others churn them; each must still be whole.
+void thr_job_walk_text(list::list<std::string>* texts,
+        std::atomic<bool>* done, std::atomic<bool>* garbage) {
+    texts->thread_attach();
+    while (!done->load()) {
+        for (const std::string& e : *texts) {
+            if (e.size() != 40 || e[0] < 'a' || e[0] > 'z' ||
+                    e.find_first_not_of(e[0]) != std::string::npos) {
+                garbage->store(true);
+            }
+        }
+    }
+}
+
+// Pushes MANY / NUM_THR values tagged with the producer, in order.
+void thr_job_produce(size_t num, list::queue<long long>* queue) {
+    for (size_t i = 0; i < MANY / NUM_THR; ++i) {
+        queue->push_back(static_cast<long long>(num * MANY + i));
+    }
+}
+
+// Pops until every value is taken; values of one producer must come out
+// in the order it pushed them. empty() runs alongside the pops.
+void thr_job_consume(list::queue<long long>* queue,
+        std::atomic<size_t>* count, std::atomic<long long>* sum,
+        std::atomic<bool>* reordered) {
+    std::vector<long long> last(QUEUE_THR, -1);
+    long long popped = 0;
+    while (count->load() < QUEUE_THR * (MANY / NUM_THR)) {
+        long long out = 0;
+        if (!queue->try_pop_front(out)) {
+            if (queue->empty()) {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        size_t from = static_cast<size_t>(out) / MANY;
+        long long i = static_cast<long long>(static_cast<size_t>(out) % MANY);
+        if (i <= last[from]) {
+            reordered->store(true);
+        }
+        last[from] = i;
+        popped += out;
+        count->fetch_add(1);
+    }
+    sum->fetch_add(popped);
+}
+
+// Inserts, erases and looks up random keys in two sets that share one
+// allocator and hazard domain, counting the inserts and erases that took
+// effect for each key.
+void thr_job_set(size_t num, list::ordered_set<int>* sets,
+        std::atomic<long>* net) {
+    std::mt19937 gen(static_cast<unsigned>(num));
+    for (size_t i = 0; i < MANY / NUM_THR; ++i) {
+        int key = static_cast<int>(gen() % SET_KEYS);
+        list::ordered_set<int>& set = sets[key % 2];
+        switch (gen() % 3) {
+            case 0:
+                if (set.insert(key)) {
+                    net[key].fetch_add(1);
+                }
+                break;
+            case 1:
+                if (set.erase(key)) {
+                    net[key].fetch_sub(1);
+                }
+                break;
+            default:
+                set.contains(key);
+        }
+    }
+}
+
 int main(int argc, char* argv[]) {
     std::ios_base::sync_with_stdio(false);
     if (argc > 1) {
@@ -111,4 +241,105 @@ int main(int argc, char* argv[]) {
         std::cout << e << " ";
     }
     std::cout << std::endl;
+
+    list::list<int> recycled(static_cast<size_t>(2));
+    std::atomic<long long> popped(0);
+    std::atomic<bool> done(false);
+    std::atomic<bool> garbage(false);
+    std::thread walk(&thr_job_walk, &recycled, &done, &garbage);
+    std::vector<std::thread> churn;
+    for (size_t i = 0; i < 2 * NUM_THR; ++i) {
+        churn.push_back(std::thread(&thr_job_recycle, &recycled, &popped));
+    }
+    for (size_t i = 0; i < churn.size(); ++i) {
+        churn[i].join();
+    }
+    done.store(true);
+    walk.join();
+
+    long long pushed = 0;
+    for (size_t i = 0; i < MANY / NUM_THR; ++i) {
+        pushed += static_cast<long long>(i % 1000) + 1;
+    }
+    pushed *= static_cast<long long>(churn.size());
+    long long left = 0;
+    for (auto e : recycled) {
+        left += e;
+    }
+    std::cout << (popped + left == pushed ? "Recycled" : "Lost") << " "
+        << (garbage ? "Garbage" : "Walked") << " "
+        << recycled.size() << " " << recycled.stats().allocations
+        << std::endl;
+
+    list::list<std::string> texts;
+    std::atomic<long long> taken(0);
+    std::atomic<bool> texts_done(false);
+    std::atomic<bool> torn(false);
+    std::thread walk_text(&thr_job_walk_text, &texts, &texts_done, &torn);
+    std::vector<std::thread> churn_text;
+    for (size_t i = 0; i < 2 * NUM_THR; ++i) {
+        churn_text.push_back(std::thread(&thr_job_recycle_text, &texts,
+            &taken));
+    }
+    for (size_t i = 0; i < churn_text.size(); ++i) {
+        churn_text[i].join();
+    }
+    texts_done.store(true);
+    walk_text.join();
+
+    long long kept = static_cast<long long>(texts.size());
+    std::cout << (taken + kept == static_cast<long long>(
+            churn_text.size() * (MANY / NUM_THR)) ? "Recycled" : "Lost")
+        << " " << (torn ? "Garbage" : "Walked") << " " << texts.size()
+        << std::endl;
+
+    list::queue<long long> queue;
+    std::atomic<size_t> dequeued(0);
+    std::atomic<long long> dequeued_sum(0);
+    std::atomic<bool> reordered(false);
+    std::vector<std::thread> ends;
+    for (size_t i = 0; i < QUEUE_THR; ++i) {
+        ends.push_back(std::thread(&thr_job_produce, i, &queue));
+        ends.push_back(std::thread(&thr_job_consume, &queue, &dequeued,
+            &dequeued_sum, &reordered));
+    }
+    for (size_t i = 0; i < ends.size(); ++i) {
+        ends[i].join();
+    }
+
+    long long enqueued = 0;
+    for (size_t p = 0; p < QUEUE_THR; ++p) {
+        for (size_t i = 0; i < MANY / NUM_THR; ++i) {
+            enqueued += static_cast<long long>(p * MANY + i);
+        }
+    }
+    std::cout << (dequeued_sum == enqueued ? "Queued" : "Lost") << " "
+        << (reordered ? "Reordered" : "FIFO") << " " << queue.size()
+        << " " << (queue.empty() ? "Empty" : "Left") << std::endl;
+
+    list::ordered_set<int>::resources shared;
+    list::ordered_set<int> sets[2] = {
+        list::ordered_set<int>(shared), list::ordered_set<int>(shared)
+    };
+    std::vector<std::atomic<long>> net(SET_KEYS);
+    std::vector<std::thread> setters;
+    for (size_t i = 0; i < SET_THR; ++i) {
+        setters.push_back(std::thread(&thr_job_set, i, sets, net.data()));
+    }
+    for (size_t i = 0; i < setters.size(); ++i) {
+        setters[i].join();
+    }
+
+    bool consistent = true;
+    size_t present = 0;
+    for (int key = 0; key < SET_KEYS; ++key) {
+        bool found = sets[key % 2].contains(key);
+        if (net[key].load() != (found ? 1 : 0)) {
+            consistent = false;
+        }
+        present += found ? 1 : 0;
+    }
+    std::cout << (consistent ? "Consistent" : "Inconsistent") << " "
+        << present << " " << sets[0].size() + sets[1].size()
+        << std::endl;
 }
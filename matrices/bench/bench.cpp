@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "LU.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+
+static size_t MAX_THREADS = std::max(1u, std::thread::hardware_concurrency());
+static size_t MAX_SIZE = 1024;
+static size_t REPS = 5;
+static const size_t WARMUP = 1;
+static const size_t VALIDATE_MAX = 256;
+
+struct Shape {
+    const char* name;
+    size_t m;
+    size_t n;
+    size_t k;
+};
+
+struct Stats {
+    double min;
+    double p50;
+    double p90;
+    double max;
+};
+
+static Stats measure(const std::function<void(void)>& run) {
+    forn(i, WARMUP) {
+        run();
+    }
+    std::vector<double> times;
+    forn(i, REPS) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    auto at = [&times](double q) {
+        return times[std::min(times.size() - 1,
+            static_cast<size_t>(q * static_cast<double>(times.size())))];
+    };
+    return Stats{times.front(), at(0.5), at(0.9), times.back()};
+}
+
+template <class T>
+static void fillRandom(T* data, size_t count, std::mt19937_64* gen) {
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    forn(i, count) {
+        data[i] = static_cast<T>(dist(*gen));
+    }
+}
+
+template <class T>
+static double maxError(const T* a, const T* b, const T* c,
+        size_t m, size_t n, size_t k) {
+    double err = 0.0;
+    forn(i, m) {
+        forn(j, n) {
+            double ref = 0.0;
+            forn(p, k) {
+                ref += static_cast<double>(a[i * k + p]) *
+                    static_cast<double>(b[p * n + j]);
+            }
+            double got = static_cast<double>(c[i * n + j]);
+            err = std::max(err, std::fabs(ref - got));
+        }
+    }
+    return err;
+}
+
+static void report(const char* type, const Shape& s, size_t threads,
+        const Stats& st, double base, double flops, double bytes,
+        double err) {
+    double speedup = base / st.p50;
+    std::printf("%-6s %-6s %5zu %5zu %5zu %3zu  %9.3f %9.3f %9.3f  "
+        "%8.2f %8.2f  %6.2f %6.2f  ",
+        type, s.name, s.m, s.n, s.k, threads,
+        st.min * 1e3, st.p50 * 1e3, st.p90 * 1e3,
+        flops / st.p50 * 1e-9, bytes / st.p50 * 1e-9,
+        speedup, speedup / static_cast<double>(threads));
+    if (err < 0.0) {
+        std::printf("%9s\n", "-");
+    } else {
+        std::printf("%9.2e\n", err);
+    }
+}
+
+static double gemmFlops(const Shape& s) {
+    return 2.0 * static_cast<double>(s.m * s.n * s.k);
+}
+
+static double gemmBytes(const Shape& s, size_t elem) {
+    return static_cast<double>((s.m * s.k + s.k * s.n + s.m * s.n) * elem);
+}
+
+// Factorization only; the error column is the max residual |Ax - b| of a
+// solve with the factors.
+static void benchLU(size_t n, std::mt19937_64* gen) {
+    Shape s = {"lu", n, n, n};
+    double flops = 2.0 / 3.0 * static_cast<double>(n * n * n);
+    double bytes = static_cast<double>(2 * n * n * sizeof(double));
+    double base = 0.0;
+    for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        matrix::Matrix a(n, n, threads);
+        fillRandom(a.Data(), n * n, gen);
+        Stats st = measure([&a]() { matrix::LU lu(a); });
+        if (threads == 1) {
+            base = st.p50;
+        }
+        double err = -1.0;
+        if (n <= VALIDATE_MAX) {
+            matrix::Vector b(n);
+            fillRandom(b.data(), n, gen);
+            matrix::Vector x = matrix::LU(a).solve(b);
+            matrix::Vector ax = a * x;
+            err = 0.0;
+            forn(i, n) {
+                err = std::max(err, std::fabs(ax[i] - b[i]));
+            }
+        }
+        report("double", s, threads, st, base, flops, bytes, err);
+    }
+}
+
+static void benchDouble(const Shape& s, std::mt19937_64* gen) {
+    double base = 0.0;
+    for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        matrix::Matrix a(s.m, s.k, threads);
+        matrix::Matrix b(s.k, s.n, threads);
+        matrix::Matrix c(s.m, s.n, threads);
+        fillRandom(a.Data(), s.m * s.k, gen);
+        fillRandom(b.Data(), s.k * s.n, gen);
+        Stats st = measure([&a, &b, &c]() { matrix::multiply(a, b, c); });
+        if (threads == 1) {
+            base = st.p50;
+        }
+        double err = -1.0;
+        if (std::max(s.m, std::max(s.n, s.k)) <= VALIDATE_MAX) {
+            err = maxError(a.Data(), b.Data(), c.Data(), s.m, s.n, s.k);
+        }
+        report("double", s, threads, st, base, gemmFlops(s),
+            gemmBytes(s, sizeof(double)), err);
+    }
+}
+
+static void benchFloat(const Shape& s, std::mt19937_64* gen) {
+    double base = 0.0;
+    std::vector<float> a(s.m * s.k);
+    std::vector<float> b(s.k * s.n);
+    std::vector<float> c(s.m * s.n);
+    fillRandom(a.data(), a.size(), gen);
+    fillRandom(b.data(), b.size(), gen);
+    for (size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        Stats st = measure([&a, &b, &c, &s, threads]() {
+            matrix::ThreadPool::shared().parallelFor(0, s.m, threads,
+                [&a, &b, &c, &s](size_t lefti, size_t righti) {
+                    matrix::kernel::gemmRows(a.data(), s.k, b.data(), s.n,
+                        c.data(), s.n, lefti, righti, s.n, s.k);
+                });
+        });
+        if (threads == 1) {
+            base = st.p50;
+        }
+        double err = -1.0;
+        if (std::max(s.m, std::max(s.n, s.k)) <= VALIDATE_MAX) {
+            err = maxError(a.data(), b.data(), c.data(), s.m, s.n, s.k);
+        }
+        report("float", s, threads, st, base, gemmFlops(s),
+            gemmBytes(s, sizeof(float)), err);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        MAX_THREADS = std::stoull(argv[1]);
+    }
+    if (argc > 2) {
+        MAX_SIZE = std::stoull(argv[2]);
+    }
+    if (argc > 3) {
+        REPS = std::max<size_t>(1, std::stoull(argv[3]));
+    }
+
+    std::vector<Shape> shapes;
+    for (size_t n = 64; n <= MAX_SIZE; n *= 2) {
+        shapes.push_back(Shape{"square", n, n, n});
+    }
+    shapes.push_back(Shape{"tall", MAX_SIZE * 4, 64, MAX_SIZE / 4});
+    shapes.push_back(Shape{"wide", 64, MAX_SIZE * 4, MAX_SIZE / 4});
+    shapes.push_back(Shape{"inner", 64, 64, MAX_SIZE * 16});
+    shapes.push_back(Shape{"outer", MAX_SIZE, MAX_SIZE, 16});
+
+    std::mt19937_64 gen(42);
+    std::printf("%-6s %-6s %5s %5s %5s %3s  %9s %9s %9s  %8s %8s  "
+        "%6s %6s  %9s\n",
+        "type", "shape", "m", "n", "k", "thr", "min,ms", "p50,ms", "p90,ms",
+        "GFLOPS", "GB/s", "speed", "eff", "maxerr");
+    for (const Shape& s : shapes) {
+        benchDouble(s, &gen);
+        benchFloat(s, &gen);
+    }
+    for (size_t n = 64; n <= MAX_SIZE; n *= 2) {
+        benchLU(n, &gen);
+    }
+
+    return 0;
+}
+
+#undef forn
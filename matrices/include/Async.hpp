@@ -0,0 +1,233 @@
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Elementwise.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+
+#ifndef MATRICES_INCLUDE_ASYNC_HPP_
+#define MATRICES_INCLUDE_ASYNC_HPP_
+
+namespace matrix {
+
+template <class T>
+struct __future_state {
+    std::mutex lock;
+    bool ready = false;
+    std::optional<T> value;
+    std::exception_ptr error;
+    std::vector<__task> continuations;
+};
+
+template <class T>
+class Promise;
+
+// Result of work running on the shared pool. Like std::shared_future the
+// value stays in the shared state, so get() can be called any number of
+// times and any number of continuations can be attached. A thread waiting
+// in get() runs queued pool tasks meanwhile, so a pool task may wait on a
+// future; it must not wait on one produced by a task that itself waits,
+// since that task could end up nested under it. then() and whenBoth()
+// never block.
+template <class T>
+class Future {
+    static_assert(!std::is_void<T>::value, "Future: void results");
+
+    public:
+        typedef T value_type;
+
+        Future(void) {}
+
+        // Already completed with a copy of value, so plain operands can be
+        // passed wherever a Future is taken.
+        Future(T value) : state_(std::make_shared<__future_state<T>>()) {
+            state_->value.emplace(std::move(value));
+            state_->ready = true;
+        }
+
+        bool valid() const { return state_ != nullptr; }
+
+        bool ready() const {
+            std::lock_guard<std::mutex> guard(state_->lock);
+            return state_->ready;
+        }
+
+        void wait() const {
+            if (!valid()) {
+                throw "Future: wait: no shared state";
+            }
+            if (ready()) {
+                return;
+            }
+            std::shared_ptr<__future_state<T>> state = state_;
+            ThreadPool::shared().helpUntil([state]() {
+                std::lock_guard<std::mutex> guard(state->lock);
+                return state->ready;
+            });
+        }
+
+        // Rethrows whatever the producing task threw.
+        const T& get() const {
+            wait();
+            if (state_->error) {
+                std::rethrow_exception(state_->error);
+            }
+            return *state_->value;
+        }
+
+        // Queues task on the pool once this future completes, with a value
+        // or an error.
+        void onReady(__task task) const {
+            {
+                std::lock_guard<std::mutex> guard(state_->lock);
+                if (!state_->ready) {
+                    state_->continuations.push_back(std::move(task));
+                    return;
+                }
+            }
+            ThreadPool::shared().submit(std::move(task));
+        }
+
+        // Future of f(get()), run on the pool when this one completes. An
+        // error here skips f and is passed on to the result.
+        template <class F>
+        Future<std::decay_t<std::invoke_result_t<F, const T&>>> then(
+                F f) const {
+            typedef std::decay_t<std::invoke_result_t<F, const T&>> R;
+            Promise<R> promise;
+            Future<T> self = *this;
+            onReady([self, promise, f]() {
+                if (self.state_->error) {
+                    promise.setError(self.state_->error);
+                    return;
+                }
+                try {
+                    promise.setValue(f(*self.state_->value));
+                } catch (...) {
+                    promise.setError(std::current_exception());
+                }
+            });
+            return promise.future();
+        }
+
+    private:
+        std::shared_ptr<__future_state<T>> state_;
+
+        explicit Future(std::shared_ptr<__future_state<T>> state) :
+            state_(std::move(state)) {}
+
+        friend class Promise<T>;
+};
+
+// Producer side of a Future. Completing it queues the continuations on the
+// pool and wakes every thread waiting in get().
+template <class T>
+class Promise {
+    public:
+        Promise(void) : state_(std::make_shared<__future_state<T>>()) {}
+
+        Future<T> future() const { return Future<T>(state_); }
+
+        void setValue(T value) const {
+            std::vector<__task> continuations;
+            {
+                std::lock_guard<std::mutex> guard(state_->lock);
+                if (state_->ready) {
+                    throw "Promise: setValue: already completed";
+                }
+                state_->value.emplace(std::move(value));
+                state_->ready = true;
+                continuations.swap(state_->continuations);
+            }
+            release_(&continuations);
+        }
+
+        void setError(std::exception_ptr error) const {
+            std::vector<__task> continuations;
+            {
+                std::lock_guard<std::mutex> guard(state_->lock);
+                if (state_->ready) {
+                    throw "Promise: setError: already completed";
+                }
+                state_->error = error;
+                state_->ready = true;
+                continuations.swap(state_->continuations);
+            }
+            release_(&continuations);
+        }
+
+    private:
+        std::shared_ptr<__future_state<T>> state_;
+
+        static void release_(std::vector<__task>* continuations) {
+            ThreadPool& pool = ThreadPool::shared();
+            for (__task& task : *continuations) {
+                pool.submit(std::move(task));
+            }
+            pool.wake();
+        }
+};
+
+// Runs f() on the shared pool.
+template <class F>
+Future<std::decay_t<std::invoke_result_t<F>>> runAsync(F f) {
+    typedef std::decay_t<std::invoke_result_t<F>> R;
+    Promise<R> promise;
+    ThreadPool::shared().submit([promise, f]() {
+        try {
+            promise.setValue(f());
+        } catch (...) {
+            promise.setError(std::current_exception());
+        }
+    });
+    return promise.future();
+}
+
+// Future of f(a.get(), b.get()), run once both complete. Nothing blocks
+// while waiting for them; the first error of a, then b, is passed on.
+template <class A, class B, class F>
+Future<std::decay_t<std::invoke_result_t<F, const A&, const B&>>> whenBoth(
+        const Future<A>& a, const Future<B>& b, F f) {
+    typedef std::decay_t<std::invoke_result_t<F, const A&, const B&>> R;
+    Promise<R> promise;
+    a.onReady([a, b, promise, f]() {
+        b.onReady([a, b, promise, f]() {
+            try {
+                promise.setValue(f(a.get(), b.get()));
+            } catch (...) {
+                promise.setError(std::current_exception());
+            }
+        });
+    });
+    return promise.future();
+}
+
+// Asynchronous counterparts of the blocking operations. Each one starts as
+// soon as its operands are ready and still splits its own work across
+// Threads() of the left operand, so independent products queued together
+// keep the whole pool busy.
+Future<Matrix> multiplyAsync(const Future<Matrix>& left,
+    const Future<Matrix>& right);
+Future<Matrix> transposeAsync(const Future<Matrix>& m);
+
+Future<Matrix> addAsync(const Future<Matrix>& left,
+    const Future<Matrix>& right);
+Future<Matrix> subtractAsync(const Future<Matrix>& left,
+    const Future<Matrix>& right);
+Future<Matrix> hadamardAsync(const Future<Matrix>& left,
+    const Future<Matrix>& right);
+Future<Matrix> scaleAsync(double alpha, const Future<Matrix>& m);
+
+template <class F>
+Future<Matrix> applyAsync(const Future<Matrix>& m, F f) {
+    return m.then([f](const Matrix& x) { return apply(x, f); });
+}
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_ASYNC_HPP_
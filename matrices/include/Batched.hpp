@@ -0,0 +1,87 @@
+#include <cstddef>
+
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+
+#ifndef MATRICES_INCLUDE_BATCHED_HPP_
+#define MATRICES_INCLUDE_BATCHED_HPP_
+
+namespace matrix {
+
+// Below this many multiply-adds a batch is not worth waking the pool.
+const size_t BATCHED_PARALLEL_MIN = 1 << 16;
+
+namespace kernel {
+
+// C = A * B for compile-time M x K and K x N, densely packed row-major.
+// With every bound known the compiler unrolls the inner loop and keeps the
+// row accumulator in vector registers.
+template <class T, size_t M, size_t N, size_t K>
+void gemmFixed(const T* __restrict__ a, const T* __restrict__ b,
+        T* __restrict__ c) {
+    for (size_t i = 0; i < M; ++i) {
+        T acc[N] = {};
+        for (size_t p = 0; p < K; ++p) {
+            const T aip = a[i * K + p];
+            for (size_t j = 0; j < N; ++j) {
+                acc[j] += aip * b[p * N + j];
+            }
+        }
+        for (size_t j = 0; j < N; ++j) {
+            c[i * N + j] = acc[j];
+        }
+    }
+}
+
+template <class T, size_t S>
+void gemmBatchedFixed(const T* a, size_t stride_a, const T* b,
+        size_t stride_b, T* c, size_t stride_c, size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        gemmFixed<T, S, S, S>(a + i * stride_a, b + i * stride_b,
+            c + i * stride_c);
+    }
+}
+
+}  // namespace kernel
+
+// C_i = A_i * B_i for i in [0, batch). A_i starts at a + i * stride_a and is
+// an m x k densely packed row-major matrix, likewise B_i (k x n) and C_i
+// (m x n). Square 4, 8, 16, 32 and 64 use unrolled kernels, other shapes
+// the general one. The batch is split across num_threads workers.
+template <class T>
+void gemmBatched(size_t m, size_t n, size_t k,
+        const T* a, size_t stride_a, const T* b, size_t stride_b,
+        T* c, size_t stride_c, size_t batch, size_t num_threads = 1) {
+    __range_job job;
+    if (m == n && n == k && (m == 4 || m == 8 || m == 16 || m == 32 ||
+            m == 64)) {
+        void (*fixed)(const T*, size_t, const T*, size_t, T*, size_t,
+            size_t, size_t) = nullptr;
+        switch (m) {
+            case 4: fixed = &kernel::gemmBatchedFixed<T, 4>; break;
+            case 8: fixed = &kernel::gemmBatchedFixed<T, 8>; break;
+            case 16: fixed = &kernel::gemmBatchedFixed<T, 16>; break;
+            case 32: fixed = &kernel::gemmBatchedFixed<T, 32>; break;
+            default: fixed = &kernel::gemmBatchedFixed<T, 64>; break;
+        }
+        job = [=](size_t first, size_t last) {
+            fixed(a, stride_a, b, stride_b, c, stride_c, first, last);
+        };
+    } else {
+        job = [=](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                kernel::gemmRows(a + i * stride_a, k, b + i * stride_b, n,
+                    c + i * stride_c, n, 0, m, n, k);
+            }
+        };
+    }
+
+    if (m * n * k * batch < BATCHED_PARALLEL_MIN) {
+        num_threads = 1;
+    }
+    ThreadPool::shared().parallelFor(0, batch, num_threads, job);
+}
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_BATCHED_HPP_
@@ -0,0 +1,71 @@
+#include <cstddef>
+
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+
+#ifndef MATRICES_INCLUDE_ELEMENTWISE_HPP_
+#define MATRICES_INCLUDE_ELEMENTWISE_HPP_
+
+namespace matrix {
+
+// Element-wise work over the contiguous storage is split into chunks of
+// this many elements, below which it stays on the calling thread.
+const size_t ELEMENTWISE_GRAIN = 1 << 14;
+
+// Reductions sum fixed blocks of this many elements and then add the block
+// results pairwise. Neither depends on the thread count, so results are
+// bit-identical for any number of threads.
+const size_t REDUCTION_BLOCK = 1 << 12;
+
+size_t __elementwise_parts(size_t count, size_t num_threads);
+
+Matrix operator+(const Matrix& left, const Matrix& right);
+Matrix operator-(const Matrix& left, const Matrix& right);
+Matrix operator*(double alpha, const Matrix& m);
+Matrix operator*(const Matrix& m, double alpha);
+
+Matrix& operator+=(Matrix& left, const Matrix& right);
+Matrix& operator-=(Matrix& left, const Matrix& right);
+Matrix& operator*=(Matrix& m, double alpha);
+
+// left += alpha * right
+void axpy(double alpha, const Matrix& right, Matrix& left);
+
+Matrix hadamard(const Matrix& left, const Matrix& right);
+
+template <class F>
+void applyInPlace(Matrix& m, F f) {
+    double* data = m.Data();
+    size_t count = m.Rows() * m.Cols();
+    ThreadPool::shared().parallelFor(0, count,
+        __elementwise_parts(count, m.Threads()),
+        [data, &f](size_t lefti, size_t righti) {
+            for (size_t i = lefti; i < righti; ++i) {
+                data[i] = f(data[i]);
+            }
+        });
+}
+
+template <class F>
+Matrix apply(const Matrix& m, F f) {
+    Matrix res(m);
+    applyInPlace(res, f);
+    return res;
+}
+
+double sum(const Matrix& m);
+Vector rowSums(const Matrix& m);
+Vector colSums(const Matrix& m);
+
+// Frobenius norm and Euclidean norms of every row and column.
+double norm(const Matrix& m);
+Vector rowNorms(const Matrix& m);
+Vector colNorms(const Matrix& m);
+
+// Largest absolute value, 0 for an empty matrix and NaN when any element
+// is NaN.
+double maxAbs(const Matrix& m);
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_ELEMENTWISE_HPP_
@@ -0,0 +1,279 @@
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+#include "Matrix.hpp"
+
+#ifndef MATRICES_INCLUDE_FIXEDMATRIX_HPP_
+#define MATRICES_INCLUDE_FIXEDMATRIX_HPP_
+
+namespace matrix {
+
+template <size_t R, size_t C, class T>
+class FixedMatrixView;
+
+// R x C matrix with the dimensions in the type and the elements inline, for
+// geometry and other small transforms in hot loops. Everything is constexpr
+// and nothing allocates; products are unrolled over every index, so it is
+// meant for small sizes. A different name from Matrix because a class
+// cannot be both a plain class and a template.
+template <size_t R, size_t C, class T = double>
+class FixedMatrix {
+    static_assert(R > 0 && C > 0, "FixedMatrix: empty dimensions");
+
+    public:
+        typedef T value_type;
+
+        constexpr FixedMatrix() : val_{} {}
+
+        // Row-major list of at most R * C elements, the rest are zero.
+        constexpr FixedMatrix(std::initializer_list<T> il) : val_{} {
+            size_t i = 0;
+            for (const T& x : il) {
+                if (i == R * C) {
+                    break;
+                }
+                val_[i++] = x;
+            }
+        }
+
+        // Copies the R x C block of m starting at (row, col).
+        explicit FixedMatrix(const Matrix& m, size_t row = 0,
+                size_t col = 0) : val_{} {
+            if (row + R > m.Rows() || col + C > m.Cols()) {
+                throw "FixedMatrix: FixedMatrix: block out of range";
+            }
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < C; ++j) {
+                    val_[i * C + j] = static_cast<T>(m[row + i][col + j]);
+                }
+            }
+        }
+
+        static constexpr FixedMatrix Identity() {
+            static_assert(R == C, "FixedMatrix: Identity: non-square");
+            FixedMatrix res;
+            for (size_t i = 0; i < R; ++i) {
+                res.val_[i * C + i] = T(1);
+            }
+            return res;
+        }
+
+        static constexpr size_t Rows() { return R; }
+        static constexpr size_t Cols() { return C; }
+
+        constexpr T* operator[](size_t i) { return val_ + i * C; }
+        constexpr const T* operator[](size_t i) const { return val_ + i * C; }
+
+        constexpr T* Data() { return val_; }
+        constexpr const T* Data() const { return val_; }
+
+        constexpr FixedMatrix<C, R, T> computeTransposed() const {
+            FixedMatrix<C, R, T> res;
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < C; ++j) {
+                    res[j][i] = val_[i * C + j];
+                }
+            }
+            return res;
+        }
+
+        Matrix toMatrix(size_t num_threads = 1) const {
+            Matrix res(R, C, num_threads);
+            store(res);
+            return res;
+        }
+
+        // Writes this matrix into the block of m starting at (row, col).
+        void store(Matrix& m, size_t row = 0, size_t col = 0) const {
+            if (row + R > m.Rows() || col + C > m.Cols()) {
+                throw "FixedMatrix: store: block out of range";
+            }
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < C; ++j) {
+                    m[row + i][col + j] = static_cast<double>(val_[i * C + j]);
+                }
+            }
+        }
+
+        constexpr FixedMatrix& operator+=(const FixedMatrix& other) {
+            for (size_t i = 0; i < R * C; ++i) {
+                val_[i] += other.val_[i];
+            }
+            return *this;
+        }
+
+        constexpr FixedMatrix& operator-=(const FixedMatrix& other) {
+            for (size_t i = 0; i < R * C; ++i) {
+                val_[i] -= other.val_[i];
+            }
+            return *this;
+        }
+
+        constexpr FixedMatrix& operator*=(T alpha) {
+            for (size_t i = 0; i < R * C; ++i) {
+                val_[i] *= alpha;
+            }
+            return *this;
+        }
+
+        // Element by element, so a NaN anywhere makes them unequal.
+        constexpr bool operator==(const FixedMatrix& other) const {
+            for (size_t i = 0; i < R * C; ++i) {
+                if (!std::equal_to<T>()(val_[i], other.val_[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        constexpr bool operator!=(const FixedMatrix& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        T val_[R * C];
+};
+
+namespace __fixed {
+
+// c[I] = sum over p of a[I / N][p] * b[p][I % N] for every I in the pack,
+// with the sum over p unrolled as a left-to-right fold.
+template <size_t N, size_t K, class T, size_t... P>
+constexpr T dotAt(const T* a, const T* b, size_t i, size_t j,
+        std::index_sequence<P...>) {
+    T acc = T(0);
+    ((acc += a[i * K + P] * b[P * N + j]), ...);
+    return acc;
+}
+
+template <size_t N, size_t K, class T, size_t... I>
+constexpr void multiply(const T* a, const T* b, T* c,
+        std::index_sequence<I...>) {
+    ((c[I] = dotAt<N, K>(a, b, I / N, I % N,
+        std::make_index_sequence<K>())), ...);
+}
+
+}  // namespace __fixed
+
+template <size_t R, size_t K, size_t C, class T>
+constexpr FixedMatrix<R, C, T> operator*(const FixedMatrix<R, K, T>& left,
+        const FixedMatrix<K, C, T>& right) {
+    FixedMatrix<R, C, T> res;
+    __fixed::multiply<C, K>(left.Data(), right.Data(), res.Data(),
+        std::make_index_sequence<R * C>());
+    return res;
+}
+
+template <size_t R, size_t C, class T>
+constexpr FixedMatrix<R, C, T> operator+(FixedMatrix<R, C, T> left,
+        const FixedMatrix<R, C, T>& right) {
+    return left += right;
+}
+
+template <size_t R, size_t C, class T>
+constexpr FixedMatrix<R, C, T> operator-(FixedMatrix<R, C, T> left,
+        const FixedMatrix<R, C, T>& right) {
+    return left -= right;
+}
+
+// The scalar is converted to T rather than deduced, so 2 * m works for a
+// double m.
+template <size_t R, size_t C, class T>
+constexpr FixedMatrix<R, C, T> operator*(
+        typename FixedMatrix<R, C, T>::value_type alpha,
+        FixedMatrix<R, C, T> m) {
+    return m *= alpha;
+}
+
+template <size_t R, size_t C, class T>
+constexpr FixedMatrix<R, C, T> operator*(FixedMatrix<R, C, T> m,
+        typename FixedMatrix<R, C, T>::value_type alpha) {
+    return m *= alpha;
+}
+
+// Non-owning R x C window into a row-major buffer of T, typically a block
+// of a dynamic Matrix. A const T view is read-only. Reading it into a
+// FixedMatrix and assigning one back are plain loops over the block, with
+// no allocation; the element type of the FixedMatrix may differ from T.
+// A writable view of a Matrix goes through the Matrix's mutable access on
+// every write, so a structure the Matrix was tagged with is forgotten.
+template <size_t R, size_t C, class T = double>
+class FixedMatrixView {
+    public:
+        typedef std::remove_const_t<T> value_type;
+
+        FixedMatrixView(void) = delete;
+
+        FixedMatrixView(T* data, size_t ld, Matrix* owner = nullptr) :
+            data_(data), ld_(ld), owner_(owner) {}
+
+        static constexpr size_t Rows() { return R; }
+        static constexpr size_t Cols() { return C; }
+
+        T* operator[](size_t i) const { return writable_() + i * ld_; }
+
+        template <class U = value_type>
+        FixedMatrix<R, C, U> load() const {
+            FixedMatrix<R, C, U> res;
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < C; ++j) {
+                    res[i][j] = static_cast<U>(data_[i * ld_ + j]);
+                }
+            }
+            return res;
+        }
+
+        template <class U>
+        const FixedMatrixView& operator=(const FixedMatrix<R, C, U>& m) const {
+            static_assert(!std::is_const<T>::value,
+                "FixedMatrixView: operator=: read-only view");
+            T* data = writable_();
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < C; ++j) {
+                    data[i * ld_ + j] = static_cast<T>(m[i][j]);
+                }
+            }
+            return *this;
+        }
+
+    private:
+        T* data_;
+        size_t ld_;
+        Matrix* owner_;
+
+        T* writable_() const {
+            if constexpr (!std::is_const<T>::value) {
+                if (owner_ != nullptr) {
+                    owner_->Data();
+                }
+            }
+            return data_;
+        }
+};
+
+template <size_t R, size_t C>
+FixedMatrixView<R, C, double> view(Matrix& m, size_t row = 0,
+        size_t col = 0) {
+    if (row + R > m.Rows() || col + C > m.Cols()) {
+        throw "FixedMatrix: view: block out of range";
+    }
+    return FixedMatrixView<R, C, double>(m[row] + col, m.Cols(), &m);
+}
+
+// Read-only window. A read-only (for example mapped) Matrix has to be
+// viewed through a const reference, the overload above would throw.
+template <size_t R, size_t C>
+FixedMatrixView<R, C, const double> view(const Matrix& m, size_t row = 0,
+        size_t col = 0) {
+    if (row + R > m.Rows() || col + C > m.Cols()) {
+        throw "FixedMatrix: view: block out of range";
+    }
+    return FixedMatrixView<R, C, const double>(m[row] + col, m.Cols());
+}
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_FIXEDMATRIX_HPP_
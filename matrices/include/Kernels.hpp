@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#ifndef MATRICES_INCLUDE_KERNELS_HPP_
+#define MATRICES_INCLUDE_KERNELS_HPP_
+
+namespace matrix {
+namespace kernel {
+
+// Row-major blocking sizes, in elements: a KC x NC panel of B stays in L2
+// while every row of the current range streams over it.
+const size_t KC = 128;
+const size_t NC = 256;
+
+// C[r0, r1) = A[r0, r1) * B, where element (i, p) of the m x k matrix A is
+// a[i * ars + p * acs], B is k x n and C is m x n, both row-major with
+// leading dimensions ldb and ldc. Every C element is summed in ascending k,
+// so the result does not depend on how rows are split between threads.
+template <class T>
+void gemmRowsStrided(const T* a, size_t ars, size_t acs,
+        const T* b, size_t ldb, T* c, size_t ldc,
+        size_t r0, size_t r1, size_t n, size_t k, bool accumulate) {
+    if (!accumulate) {
+        for (size_t i = r0; i < r1; ++i) {
+            std::fill(c + i * ldc, c + i * ldc + n, T(0));
+        }
+    }
+
+    for (size_t jj = 0; jj < n; jj += NC) {
+        size_t jn = std::min(NC, n - jj);
+        for (size_t kk = 0; kk < k; kk += KC) {
+            size_t kn = std::min(KC, k - kk);
+            size_t i = r0;
+            for (; i + 4 <= r1; i += 4) {
+                T* __restrict__ c0 = c + i * ldc + jj;
+                T* __restrict__ c1 = c0 + ldc;
+                T* __restrict__ c2 = c1 + ldc;
+                T* __restrict__ c3 = c2 + ldc;
+                for (size_t p = kk; p < kk + kn; ++p) {
+                    const T a0 = a[i * ars + p * acs];
+                    const T a1 = a[(i + 1) * ars + p * acs];
+                    const T a2 = a[(i + 2) * ars + p * acs];
+                    const T a3 = a[(i + 3) * ars + p * acs];
+                    const T* __restrict__ bp = b + p * ldb + jj;
+                    for (size_t j = 0; j < jn; ++j) {
+                        c0[j] += a0 * bp[j];
+                        c1[j] += a1 * bp[j];
+                        c2[j] += a2 * bp[j];
+                        c3[j] += a3 * bp[j];
+                    }
+                }
+            }
+            for (; i < r1; ++i) {
+                T* __restrict__ c0 = c + i * ldc + jj;
+                for (size_t p = kk; p < kk + kn; ++p) {
+                    const T a0 = a[i * ars + p * acs];
+                    const T* __restrict__ bp = b + p * ldb + jj;
+                    for (size_t j = 0; j < jn; ++j) {
+                        c0[j] += a0 * bp[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// C[r0, r1) = A[r0, r1) * B with A row-major.
+template <class T>
+void gemmRows(const T* a, size_t lda, const T* b, size_t ldb,
+        T* c, size_t ldc, size_t r0, size_t r1, size_t n, size_t k,
+        bool accumulate = false) {
+    gemmRowsStrided(a, lda, size_t(1), b, ldb, c, ldc, r0, r1, n, k,
+        accumulate);
+}
+
+// C[r0, r1) = (A^T * B)[r0, r1) where A is stored row-major as k x m.
+template <class T>
+void gemmTNRows(const T* a, size_t lda, const T* b, size_t ldb,
+        T* c, size_t ldc, size_t r0, size_t r1, size_t n, size_t k,
+        bool accumulate = false) {
+    gemmRowsStrided(a, size_t(1), lda, b, ldb, c, ldc, r0, r1, n, k,
+        accumulate);
+}
+
+// dst[j][i] = src[i][j] for i in [r0, r1), j in [c0, c1). Splits the longer
+// side until a tile fits in L1, so both sides are read and written a cache
+// line at a time whatever the cache sizes are.
+const size_t TRANSPOSE_TILE = 32;
+
+template <class T>
+void transposeBlock(const T* src, size_t lds, T* dst, size_t ldd,
+        size_t r0, size_t r1, size_t c0, size_t c1) {
+    if (r1 - r0 <= TRANSPOSE_TILE && c1 - c0 <= TRANSPOSE_TILE) {
+        for (size_t i = r0; i < r1; ++i) {
+            for (size_t j = c0; j < c1; ++j) {
+                dst[j * ldd + i] = src[i * lds + j];
+            }
+        }
+        return;
+    }
+    if (r1 - r0 >= c1 - c0) {
+        size_t mid = r0 + (r1 - r0) / 2;
+        transposeBlock(src, lds, dst, ldd, r0, mid, c0, c1);
+        transposeBlock(src, lds, dst, ldd, mid, r1, c0, c1);
+    } else {
+        size_t mid = c0 + (c1 - c0) / 2;
+        transposeBlock(src, lds, dst, ldd, r0, r1, c0, mid);
+        transposeBlock(src, lds, dst, ldd, r0, r1, mid, c1);
+    }
+}
+
+// Transposes tile row ti of a square n x n matrix in place: the diagonal
+// tile is transposed on itself, every tile (ti, tj) with tj > ti is swapped
+// with the transpose of (tj, ti).
+template <class T>
+void transposeTileRow(T* a, size_t lda, size_t n, size_t ti) {
+    size_t i0 = ti * TRANSPOSE_TILE;
+    size_t i1 = std::min(i0 + TRANSPOSE_TILE, n);
+    for (size_t i = i0; i < i1; ++i) {
+        for (size_t j = i + 1; j < i1; ++j) {
+            std::swap(a[i * lda + j], a[j * lda + i]);
+        }
+    }
+    for (size_t j0 = i1; j0 < n; j0 += TRANSPOSE_TILE) {
+        size_t j1 = std::min(j0 + TRANSPOSE_TILE, n);
+        for (size_t i = i0; i < i1; ++i) {
+            for (size_t j = j0; j < j1; ++j) {
+                std::swap(a[i * lda + j], a[j * lda + i]);
+            }
+        }
+    }
+}
+
+// One 16-byte vector, the SIMD width every x86-64 target has. Loads go
+// through memcpy, so no alignment is assumed.
+template <class T>
+struct __simd {
+    typedef T type __attribute__((vector_size(16)));
+    static const size_t width = 16 / sizeof(T);
+
+    static type load(const T* p) {
+        type v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static void store(T* p, type v) {
+        std::memcpy(p, &v, sizeof(v));
+    }
+
+    static T sum(type v) {
+        T res = v[0];
+        for (size_t i = 1; i < width; ++i) {
+            res += v[i];
+        }
+        return res;
+    }
+};
+
+// Sum of x[i] * y[i] with two vector accumulators. The order of additions
+// only depends on n.
+template <class T>
+T dot(const T* __restrict__ x, const T* __restrict__ y, size_t n) {
+    typedef __simd<T> simd;
+    typename simd::type acc0 = {};
+    typename simd::type acc1 = {};
+    size_t i = 0;
+    for (; i + 2 * simd::width <= n; i += 2 * simd::width) {
+        acc0 += simd::load(x + i) * simd::load(y + i);
+        acc1 += simd::load(x + i + simd::width) *
+            simd::load(y + i + simd::width);
+    }
+    if (i + simd::width <= n) {
+        acc0 += simd::load(x + i) * simd::load(y + i);
+        i += simd::width;
+    }
+    T res = simd::sum(acc0 + acc1);
+    for (; i < n; ++i) {
+        res += x[i] * y[i];
+    }
+    return res;
+}
+
+// Sum of x[i] (squares, if `square`) with the accumulator layout of dot().
+template <class T>
+T sum(const T* __restrict__ x, size_t n, bool square = false) {
+    typedef __simd<T> simd;
+    typename simd::type acc0 = {};
+    typename simd::type acc1 = {};
+    size_t i = 0;
+    for (; i + 2 * simd::width <= n; i += 2 * simd::width) {
+        typename simd::type v0 = simd::load(x + i);
+        typename simd::type v1 = simd::load(x + i + simd::width);
+        if (square) {
+            v0 *= v0;
+            v1 *= v1;
+        }
+        acc0 += v0;
+        acc1 += v1;
+    }
+    T res = simd::sum(acc0 + acc1);
+    for (; i < n; ++i) {
+        res += square ? x[i] * x[i] : x[i];
+    }
+    return res;
+}
+
+// Adds partial sums as a balanced binary tree, in place. The grouping only
+// depends on the number of partials.
+template <class T>
+T pairwiseSum(T* partial, size_t n) {
+    if (n == 0) {
+        return T(0);
+    }
+    for (size_t step = 1; step < n; step *= 2) {
+        for (size_t i = 0; i + step < n; i += 2 * step) {
+            partial[i] += partial[i + step];
+        }
+    }
+    return partial[0];
+}
+
+// y += alpha * x
+template <class T>
+void axpy(T alpha, const T* __restrict__ x, T* __restrict__ y, size_t n) {
+    typedef __simd<T> simd;
+    size_t i = 0;
+    for (; i + simd::width <= n; i += simd::width) {
+        simd::store(y + i, simd::load(y + i) + alpha * simd::load(x + i));
+    }
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+// y[r0, r1) = A[r0, r1) * x
+template <class T>
+void gemvRows(const T* a, size_t lda, const T* x, T* y,
+        size_t r0, size_t r1, size_t n) {
+    for (size_t i = r0; i < r1; ++i) {
+        y[i] = dot(a + i * lda, x, n);
+    }
+}
+
+// C[r0, r1) = (A * B^T)[r0, r1) where B is stored row-major as n x k. Rows
+// of B are taken in blocks of about 256 KiB so they are reused from L2 by
+// every row of the range.
+template <class T>
+void gemmNTRows(const T* a, size_t lda, const T* b, size_t ldb,
+        T* c, size_t ldc, size_t r0, size_t r1, size_t n, size_t k) {
+    size_t block = std::max<size_t>(1,
+        (size_t(1) << 18) / (sizeof(T) * std::max<size_t>(1, k)));
+    for (size_t jj = 0; jj < n; jj += block) {
+        size_t je = std::min(jj + block, n);
+        for (size_t i = r0; i < r1; ++i) {
+            for (size_t j = jj; j < je; ++j) {
+                c[i * ldc + j] = dot(a + i * lda, b + j * ldb, k);
+            }
+        }
+    }
+}
+
+// y[c0, c1) = (A^T * x)[c0, c1) for an m x n matrix A. Rows of A are
+// streamed once, the output stripe stays in cache.
+template <class T>
+void gemvTransposedCols(const T* a, size_t lda, const T* x, T* y,
+        size_t c0, size_t c1, size_t m) {
+    std::fill(y + c0, y + c1, T(0));
+    for (size_t i = 0; i < m; ++i) {
+        axpy(x[i], a + i * lda + c0, y + c0, c1 - c0);
+    }
+}
+
+}  // namespace kernel
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_KERNELS_HPP_
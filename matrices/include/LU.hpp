@@ -0,0 +1,60 @@
+#include <cstddef>
+#include <vector>
+
+#include "Matrix.hpp"
+
+#ifndef MATRICES_INCLUDE_LU_HPP_
+#define MATRICES_INCLUDE_LU_HPP_
+
+namespace matrix {
+
+const size_t LU_BLOCK = 64;
+
+// PA = LU with partial pivoting, blocked and right-looking: each step
+// factors a panel of `block` columns, solves for the matching rows of U and
+// updates the trailing matrix with the parallel GEMM kernel on a.Threads()
+// workers.
+class LU {
+    public:
+        LU(void) = delete;
+
+        explicit LU(const Matrix& a, size_t block = LU_BLOCK);
+
+        size_t Size() const;
+
+        // L below the diagonal (unit diagonal implied) and U on and above.
+        const Matrix& Factors() const;
+
+        // Row i was swapped with row Pivots()[i] at step i.
+        const std::vector<size_t>& Pivots() const;
+
+        bool isSingular() const;
+
+        double determinant() const;
+
+        Vector solve(const Vector& b) const;
+        Matrix solve(const Matrix& b) const;
+
+        Matrix inverse() const;
+
+    private:
+        Matrix lu_;
+        std::vector<size_t> piv_;
+        bool odd_;
+        bool singular_;
+
+        void factorPanel_(size_t k0, size_t kb);
+        void solveRowsOfU_(size_t k0, size_t kb);
+        void updateTrailing_(size_t k0, size_t kb);
+        void solveInPlace_(Matrix& x) const;
+};
+
+// x with a * x = b. Identity, diagonal and triangular a (see
+// Matrix::structure()) are solved directly, within their bandwidths, and
+// anything else through LU.
+Vector solve(const Matrix& a, const Vector& b);
+Matrix solve(const Matrix& a, const Matrix& b);
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_LU_HPP_
@@ -1,3 +1,9 @@
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
@@ -10,50 +16,212 @@ typedef std::vector<double> Vector;
 typedef std::vector<Vector> __matrix;
 typedef std::pair<size_t, size_t> __m_size_t;
 
+// Where the non-zeros of a matrix may be. Banded means zero outside
+// LowerBandwidth() diagonals below the main one and UpperBandwidth() above.
+// Everything except General implies a square matrix.
+enum class Structure {
+    General,
+    Identity,
+    Diagonal,
+    UpperTriangular,
+    LowerTriangular,
+    Banded
+};
+
+// A Structure with its bandwidths.
+struct __m_structure {
+    Structure structure;
+    size_t lower;
+    size_t upper;
+};
+
+// Bands at most this fraction of the order wide count as Banded.
+const size_t BAND_MAX_FRACTION = 4;
+
 class Matrix {
     public:
         struct __thr_m_j_input {
             const Matrix& left;
-            const Matrix& tright;
+            const Matrix& right;
             const size_t lefti;
             const size_t righti;
-            __matrix& res;
+            Matrix& res;
         };
 
         Matrix(void) = delete;
 
         explicit Matrix(size_t rows, size_t cols = 0, size_t num_threads = 1);
 
-        explicit Matrix(const __matrix& val);
+        explicit Matrix(const __matrix& val, size_t num_threads = 1);
 
         Matrix(const Matrix& other);
 
-        Matrix operator=(const Matrix& other);
+        Matrix(Matrix&& other) noexcept;
+
+        Matrix& operator=(const Matrix& other);
+
+        Matrix& operator=(Matrix&& other) noexcept;
+
+        static Matrix Identity(size_t n, size_t num_threads = 1);
+
+        // Wraps storage owned by `buf` without copying it. A read-only
+        // matrix throws on mutable access and gets a private buffer the
+        // first time it is resized or assigned to.
+        static Matrix View(std::shared_ptr<double> buf, size_t rows,
+            size_t cols, bool read_only, size_t num_threads = 1);
 
         __m_size_t Size() const;
         size_t Rows() const;
         size_t Cols() const;
+        size_t Threads() const;
+        bool ReadOnly() const;
+
+        void setThreads(size_t num_threads);
+
+        double* operator[](size_t i);
+        const double* operator[](size_t i) const;
+
+        // Row-major storage, rows_ * cols_ elements without padding.
+        double* Data();
+        const double* Data() const;
+
+        // Memory node holding the start of each row, -1 where unknown.
+        // Large matrices are first touched row block by row block on the
+        // workers multiply uses for them, so with a pinned pool the rows
+        // follow the worker nodes.
+        std::vector<int> rowNodes() const;
+
+        // Changes the shape, reusing the buffer when it is large enough.
+        // Contents are unspecified afterwards.
+        void resize(size_t rows, size_t cols);
+
+        void swap(Matrix& other) noexcept;
 
-        Vector& operator[](size_t i);
-        Vector operator[](size_t i) const;
+        bool isIdentity() const;
+        bool isDiagonal() const;
+
+        // Set by the caller, who vouches for it, or else detected on every
+        // call by a scan that stops as soon as the matrix turns out to be
+        // general. Only a set structure is kept, since the storage can be
+        // written through pointers and views handed out earlier; any
+        // mutable access forgets it. Products route on it.
+        Structure structure() const;
+        size_t LowerBandwidth() const;
+        size_t UpperBandwidth() const;
+
+        // Bandwidths are only read for Banded; the other kinds imply them.
+        void setStructure(Structure structure, size_t lower = 0,
+            size_t upper = 0);
 
         Matrix computeTransposed() const;
 
+        // Square matrices only.
+        void transposeInPlace();
+
         friend Matrix operator*(const Matrix& left, const Matrix& right);
+        friend bool multiplyStructured(const Matrix& left,
+            const Matrix& right, Matrix& res);
 
         ~Matrix();
 
     private:
-        __matrix val_;
+        std::shared_ptr<double> val_;
         size_t rows_;
         size_t cols_;
+        size_t capacity_;
+        bool readOnly_;
 
         size_t nThreads_;
+
+        // Structure given to setStructure(), -1 when none is. The bandwidths
+        // are published before it, so concurrent readers of a const matrix
+        // see a consistent triple.
+        mutable std::atomic<int> structure_{-1};
+        mutable std::atomic<size_t> lower_{0};
+        mutable std::atomic<size_t> upper_{0};
+
+        double* mutableData_();
+        void forgetStructure_();
+        void copyStructure_(const Matrix& other);
+        __m_structure structureInfo_() const;
+        __m_structure detectStructure_() const;
 };
 
+// A^T without materializing it. Products take it as an operand and read the
+// original storage with transposed indexing; the referenced Matrix must
+// outlive the view.
+class Transposed {
+    public:
+        Transposed(void) = delete;
+
+        explicit Transposed(const Matrix& base);
+
+        const Matrix& Base() const;
+        size_t Rows() const;
+        size_t Cols() const;
+
+    private:
+        const Matrix& base_;
+};
+
+Transposed transposed(const Matrix& m);
+
+Matrix operator*(const Matrix& left, const Transposed& right);
+Matrix operator*(const Transposed& left, const Matrix& right);
+
 void threadMultiplyJob(Matrix::__thr_m_j_input in);
 
-std::ostream& operator<<(std::ostream& os, Matrix to_print);
+// res = left * right on the shared worker pool. res is reshaped in place, so
+// a buffer of the right size is reused instead of reallocated.
+void multiply(const Matrix& left, const Matrix& right, Matrix& res);
+
+// res = left * right over only the blocks and bands that can be non-zero,
+// with the same result as the dense product when every element is finite.
+// An Inf or NaN multiplied by a zero outside a band is skipped, so the NaN
+// the dense product gets from 0 * Inf does not appear. Returns false
+// without touching res when both operands are General.
+bool multiplyStructured(const Matrix& left, const Matrix& right,
+    Matrix& res);
+
+void multiply(const Matrix& left, const Transposed& right, Matrix& res);
+void multiply(const Transposed& left, const Matrix& right, Matrix& res);
+
+// y = A * x and y = A^T * x, split across the matrix's threads by output
+// element. The raw-pointer forms write into caller-provided storage.
+Vector operator*(const Matrix& a, const Vector& x);
+Vector multiplyTransposed(const Matrix& a, const Vector& x);
+void gemv(const Matrix& a, const double* x, double* y);
+void gemvTransposed(const Matrix& a, const double* x, double* y);
+
+// ys[v] = A * xs[v] for every row v of xs. A is walked in cache-sized row
+// blocks, each block is applied to all vectors before moving on.
+void gemvBatched(const Matrix& a, const Matrix& xs, Matrix& ys);
+
+// base^k by repeated squaring.
+Matrix pow(const Matrix& base, size_t k);
+
+// base^(2^times), ping-ponging between two buffers.
+Matrix squareRepeated(const Matrix& base, size_t times);
+
+typedef std::vector<std::reference_wrapper<const Matrix>> __matrix_chain;
+
+// chain[0] * chain[1] * ... with the parenthesization that needs the fewest
+// multiply-adds, found by dynamic programming over the dimensions.
+// Independent sub-products run concurrently and intermediates reuse each
+// other's buffers. Rounding may differ from left-to-right evaluation.
+// Matrices owned by a container are passed as
+// __matrix_chain(v.begin(), v.end()).
+Matrix multiplyChain(const __matrix_chain& chain);
+
+// The same for operands passed one by one, temporaries included: they live
+// until the end of the call, so none of them is copied.
+template <class... M, class = std::enable_if_t<sizeof...(M) != 0 &&
+    std::conjunction_v<std::is_same<std::decay_t<M>, Matrix>...>>>
+Matrix multiplyChain(const M&... chain) {
+    return multiplyChain(__matrix_chain{std::cref(chain)...});
+}
+
+std::ostream& operator<<(std::ostream& os, const Matrix& to_print);
 
 }  // namespace matrix
 
@@ -0,0 +1,58 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Matrix.hpp"
+
+#ifndef MATRICES_INCLUDE_MATRIXIO_HPP_
+#define MATRICES_INCLUDE_MATRIXIO_HPP_
+
+namespace matrix {
+
+// Binary layout: this header at offset 0, then rows * cols elements in
+// row-major order starting at dataOffset. dataOffset is a multiple of
+// alignment (the page size when written), so the data can be mapped
+// directly.
+struct __m_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t alignment;
+    uint64_t dataOffset;
+    uint8_t reserved[16];
+};
+
+const char M_FILE_MAGIC[8] = {'M', 'T', 'R', 'X', 'B', 'I', 'N', '\0'};
+const uint32_t M_FILE_VERSION = 1;
+const uint32_t M_DTYPE_F64_LE = 1;
+
+enum class Access { Normal, Sequential, Random, WillNeed };
+
+void writeBinary(const Matrix& m, const std::string& path);
+
+// Zero-filled file of the given shape, without holding it in memory.
+void createBinary(const std::string& path, size_t rows, size_t cols);
+
+Matrix readBinary(const std::string& path, size_t num_threads = 1);
+
+// Zero-copy read-only view of a binary file. The mapping lives as long as
+// the returned matrix and every copy of its buffer.
+Matrix mapBinary(const std::string& path, Access advice = Access::Normal,
+    size_t num_threads = 1);
+
+// Rejects headers whose data is misaligned, too large for a file offset or
+// longer than the file.
+__m_file_header readHeader(const std::string& path);
+
+// Text format: "rows cols" on the first line, then one line per row. Rows
+// are formatted and parsed in parallel on m.Threads() / num_threads workers.
+// A row line with more or fewer than cols numbers is rejected.
+void writeText(const Matrix& m, const std::string& path);
+
+Matrix readText(const std::string& path, size_t num_threads = 1);
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_MATRIXIO_HPP_
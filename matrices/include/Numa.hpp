@@ -0,0 +1,36 @@
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#ifndef MATRICES_INCLUDE_NUMA_HPP_
+#define MATRICES_INCLUDE_NUMA_HPP_
+
+namespace matrix {
+
+namespace numa {
+
+// Number of memory nodes with CPUs, 1 when the topology is not exposed.
+size_t nodeCount();
+
+// IDs of the online memory nodes, ascending; they need not be contiguous.
+// {0} when the topology is not exposed.
+std::vector<int> onlineNodes();
+
+// Node owning the CPU, 0 when unknown.
+int nodeOfCpu(int cpu);
+
+// CPUs this process may run on, grouped node by node and ascending within
+// a node, so consecutive workers share a node.
+std::vector<int> placementCpus();
+
+bool pinThread(std::thread& thread, int cpu);
+
+// Node currently backing each page, or -1 for pages not yet touched or
+// when the kernel cannot tell.
+std::vector<int> pageNodes(const std::vector<const void*>& pages);
+
+}  // namespace numa
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_NUMA_HPP_
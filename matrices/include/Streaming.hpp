@@ -0,0 +1,21 @@
+#include <cstddef>
+#include <string>
+
+#ifndef MATRICES_INCLUDE_STREAMING_HPP_
+#define MATRICES_INCLUDE_STREAMING_HPP_
+
+namespace matrix {
+
+// C = A * B for matrices stored in the binary format of MatrixIO.hpp that
+// need not fit in memory. A, B and C are walked in square-ish blocks sized
+// so that two A blocks, two B blocks and two C blocks fit in memory_budget
+// bytes. A background thread reads the next pair of blocks and writes the
+// previous C block while the current one is computed on num_threads
+// workers. c_path is created or truncated; naming A or B there, through
+// any path or link, throws before anything is written.
+void multiplyFiles(const std::string& a_path, const std::string& b_path,
+    const std::string& c_path, size_t memory_budget, size_t num_threads = 1);
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_STREAMING_HPP_
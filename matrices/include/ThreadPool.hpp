@@ -0,0 +1,87 @@
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef MATRICES_INCLUDE_THREADPOOL_HPP_
+#define MATRICES_INCLUDE_THREADPOOL_HPP_
+
+namespace matrix {
+
+typedef std::function<void(void)> __task;
+typedef std::function<void(size_t, size_t)> __range_job;
+
+// Persistent workers shared by every Matrix operation. A thread waiting in
+// parallelFor runs the chunks of its own split that no worker has started,
+// so nested parallel calls made from inside a worker cannot deadlock the
+// pool.
+//
+// Besides the common queue every worker has its own, and parallelFor always
+// sends chunk i of a split to the same worker. Memory first touched through
+// parallelFor is therefore placed on the node of the worker that later
+// computes on it with the same split. Pinned pools fix each worker to one
+// CPU and never steal from other workers, so the mapping holds; only the
+// thread that called parallelFor takes chunks out of turn.
+class ThreadPool {
+    public:
+        ThreadPool(void) = delete;
+
+        explicit ThreadPool(size_t num_threads, bool pin = false);
+
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator=(const ThreadPool& other) = delete;
+
+        ~ThreadPool();
+
+        size_t Size() const;
+        bool Pinned() const;
+
+        // CPU and node of a pinned worker, -1 for unpinned pools.
+        int WorkerCpu(size_t worker) const;
+        int WorkerNode(size_t worker) const;
+
+        void submit(__task task);
+
+        // Queues the task for one worker (modulo Size()).
+        void submitTo(size_t worker, __task task);
+
+        // Splits [begin, end) into `parts` contiguous chunks exactly like
+        // the original per-call threads did and blocks until all are done.
+        // The caller runs chunk 0, chunk i goes to worker (i - 1) % Size()
+        // unless the caller gets to it first.
+        void parallelFor(size_t begin, size_t end, size_t parts,
+            const __range_job& job);
+
+        bool runPending();
+
+        // Runs queued tasks until done() holds, sleeping while there is
+        // nothing to run. done() is evaluated under the pool lock, so
+        // whoever makes it true must call wake() afterwards.
+        void helpUntil(const std::function<bool(void)>& done);
+        void wake();
+
+        // Sized to the hardware; pinned when there is more than one node.
+        static ThreadPool& shared();
+
+    private:
+        std::vector<std::thread> workers_;
+        std::vector<int> cpus_;
+        std::deque<__task> tasks_;
+        std::vector<std::deque<__task>> local_;
+        std::mutex lock_;
+        std::condition_variable cv_;
+        bool stop_;
+        bool pinned_;
+
+        bool popTask_(size_t self, bool steal, __task* task);
+        void workerLoop_(size_t self);
+};
+
+}  // namespace matrix
+
+#endif  // MATRICES_INCLUDE_THREADPOOL_HPP_
@@ -0,0 +1,41 @@
+#include "Async.hpp"
+
+namespace matrix {
+
+Future<Matrix> multiplyAsync(const Future<Matrix>& left,
+        const Future<Matrix>& right) {
+    return whenBoth(left, right, [](const Matrix& l, const Matrix& r) {
+        return l * r;
+    });
+}
+
+Future<Matrix> transposeAsync(const Future<Matrix>& m) {
+    return m.then([](const Matrix& x) { return x.computeTransposed(); });
+}
+
+Future<Matrix> addAsync(const Future<Matrix>& left,
+        const Future<Matrix>& right) {
+    return whenBoth(left, right, [](const Matrix& l, const Matrix& r) {
+        return l + r;
+    });
+}
+
+Future<Matrix> subtractAsync(const Future<Matrix>& left,
+        const Future<Matrix>& right) {
+    return whenBoth(left, right, [](const Matrix& l, const Matrix& r) {
+        return l - r;
+    });
+}
+
+Future<Matrix> hadamardAsync(const Future<Matrix>& left,
+        const Future<Matrix>& right) {
+    return whenBoth(left, right, [](const Matrix& l, const Matrix& r) {
+        return hadamard(l, r);
+    });
+}
+
+Future<Matrix> scaleAsync(double alpha, const Future<Matrix>& m) {
+    return m.then([alpha](const Matrix& x) { return alpha * x; });
+}
+
+}  // namespace matrix
@@ -0,0 +1,148 @@
+#include "Matrix.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+#define forf(i, n1, n2) for (size_t i = size_t(n1); i < size_t(n2); ++i)
+
+namespace matrix {
+
+// Released intermediates, handed out again to later products that fit in
+// them. Shared by concurrently evaluated subtrees.
+struct __chain_buffers {
+    std::mutex lock;
+    std::vector<Matrix> free;
+
+    Matrix take(size_t rows, size_t cols, size_t num_threads) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            size_t best = free.size();
+            forn(i, free.size()) {
+                size_t size = free[i].Rows() * free[i].Cols();
+                if (size >= rows * cols && (best == free.size() ||
+                        size < free[best].Rows() * free[best].Cols())) {
+                    best = i;
+                }
+            }
+            if (best != free.size()) {
+                Matrix res(std::move(free[best]));
+                free.erase(free.begin() + static_cast<long>(best));
+                res.resize(rows, cols);
+                res.setThreads(num_threads);
+                return res;
+            }
+        }
+        return Matrix(rows, cols, num_threads);
+    }
+
+    void give(Matrix&& m) {
+        std::lock_guard<std::mutex> guard(lock);
+        free.push_back(std::move(m));
+    }
+};
+
+struct __chain_plan {
+    const __matrix_chain& chain;
+    std::vector<size_t> dims;
+    std::vector<std::vector<size_t>> split;
+    size_t nThreads;
+    __chain_buffers buffers;
+
+    // res = chain[i] * ... * chain[j], i < j.
+    void evaluate(size_t i, size_t j, Matrix& res) {
+        size_t k = split[i][j];
+        Matrix left(0);
+        Matrix right(0);
+        if (i != k) {
+            left = buffers.take(dims[i], dims[k + 1], nThreads);
+        }
+        if (k + 1 != j) {
+            right = buffers.take(dims[k + 1], dims[j + 1], nThreads);
+        }
+
+        if (i != k && k + 1 != j) {
+            ThreadPool::shared().parallelFor(0, 2, 2,
+                [this, i, j, k, &left, &right](size_t lefti, size_t righti) {
+                    forf(side, lefti, righti) {
+                        if (side == 0) {
+                            evaluate(i, k, left);
+                        } else {
+                            evaluate(k + 1, j, right);
+                        }
+                    }
+                });
+        } else if (i != k) {
+            evaluate(i, k, left);
+        } else if (k + 1 != j) {
+            evaluate(k + 1, j, right);
+        }
+
+        multiply(i == k ? chain[i].get() : left,
+            k + 1 == j ? chain[j].get() : right, res);
+        if (i != k) {
+            buffers.give(std::move(left));
+        }
+        if (k + 1 != j) {
+            buffers.give(std::move(right));
+        }
+    }
+};
+
+Matrix multiplyChain(const __matrix_chain& chain) {
+    size_t n = chain.size();
+    if (n == 0) {
+        throw "Matrix: multiplyChain: unappropriate arguments";
+    }
+    size_t num_threads = 1;
+    std::vector<size_t> dims(n + 1);
+    dims[0] = chain[0].get().Rows();
+    forn(i, n) {
+        const Matrix& m = chain[i].get();
+        if (m.Rows() != dims[i]) {
+            throw "Matrix: multiplyChain: unappropriate arguments";
+        }
+        dims[i + 1] = m.Cols();
+        num_threads = std::max(num_threads, m.Threads());
+    }
+    if (n == 1) {
+        return chain[0].get();
+    }
+
+    // cost[i][j]: fewest multiply-adds for chain[i..j], split[i][j]: the
+    // last product is chain[i..k] * chain[k+1..j]. Costs are doubles since
+    // products of three large dimensions overflow quickly.
+    std::vector<std::vector<double>> cost(n, std::vector<double>(n, 0.0));
+    std::vector<std::vector<size_t>> split(n, std::vector<size_t>(n, 0));
+    forf(len, 2, n + 1) {
+        forn(i, n - len + 1) {
+            size_t j = i + len - 1;
+            cost[i][j] = std::numeric_limits<double>::infinity();
+            forf(k, i, j) {
+                double c = cost[i][k] + cost[k + 1][j] +
+                    static_cast<double>(dims[i]) *
+                    static_cast<double>(dims[k + 1]) *
+                    static_cast<double>(dims[j + 1]);
+                if (c < cost[i][j]) {
+                    cost[i][j] = c;
+                    split[i][j] = k;
+                }
+            }
+        }
+    }
+
+    __chain_plan plan = {chain, std::move(dims), std::move(split),
+        num_threads, {}};
+    Matrix res(plan.dims[0], plan.dims[n], num_threads);
+    plan.evaluate(0, n - 1, res);
+    return res;
+}
+
+}  // namespace matrix
+
+#undef forn
+#undef forf
@@ -0,0 +1,245 @@
+#include "Elementwise.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "Kernels.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+#define forf(i, n1, n2) for (size_t i = size_t(n1); i < size_t(n2); ++i)
+
+namespace matrix {
+
+// Column stripes are whole cache lines of the accumulators, so threads
+// never share one.
+static const size_t COLUMN_STRIPE = 8;
+
+struct alignas(64) __column_stripe {
+    double sums[COLUMN_STRIPE];
+};
+
+size_t __elementwise_parts(size_t count, size_t num_threads) {
+    return std::max<size_t>(1,
+        std::min(num_threads, count / ELEMENTWISE_GRAIN));
+}
+
+static void checkSameSize(const Matrix& left, const Matrix& right,
+        const char* what) {
+    if (left.Size() != right.Size()) {
+        throw what;
+    }
+}
+
+// res[i] = op(left[i], right[i]) over the flat storage.
+template <class Op>
+static void zip(const Matrix& left, const Matrix& right, Matrix& res,
+        Op op) {
+    const double* a = left.Data();
+    const double* b = right.Data();
+    double* c = res.Data();
+    size_t count = left.Rows() * left.Cols();
+    ThreadPool::shared().parallelFor(0, count,
+        __elementwise_parts(count, left.Threads()),
+        [a, b, c, op](size_t lefti, size_t righti) {
+            forf(i, lefti, righti) {
+                c[i] = op(a[i], b[i]);
+            }
+        });
+}
+
+Matrix operator+(const Matrix& left, const Matrix& right) {
+    checkSameSize(left, right, "Matrix: operator+: unappropriate arguments");
+    Matrix res(left);
+    zip(res, right, res, [](double x, double y) { return x + y; });
+    return res;
+}
+
+Matrix operator-(const Matrix& left, const Matrix& right) {
+    checkSameSize(left, right, "Matrix: operator-: unappropriate arguments");
+    Matrix res(left);
+    zip(res, right, res, [](double x, double y) { return x - y; });
+    return res;
+}
+
+Matrix operator*(double alpha, const Matrix& m) {
+    Matrix res(m);
+    res *= alpha;
+    return res;
+}
+
+Matrix operator*(const Matrix& m, double alpha) {
+    return alpha * m;
+}
+
+Matrix& operator+=(Matrix& left, const Matrix& right) {
+    checkSameSize(left, right, "Matrix: operator+=: unappropriate arguments");
+    zip(left, right, left, [](double x, double y) { return x + y; });
+    return left;
+}
+
+Matrix& operator-=(Matrix& left, const Matrix& right) {
+    checkSameSize(left, right, "Matrix: operator-=: unappropriate arguments");
+    zip(left, right, left, [](double x, double y) { return x - y; });
+    return left;
+}
+
+Matrix& operator*=(Matrix& m, double alpha) {
+    applyInPlace(m, [alpha](double x) { return alpha * x; });
+    return m;
+}
+
+void axpy(double alpha, const Matrix& right, Matrix& left) {
+    checkSameSize(left, right, "Matrix: axpy: unappropriate arguments");
+    zip(left, right, left,
+        [alpha](double x, double y) { return x + alpha * y; });
+}
+
+Matrix hadamard(const Matrix& left, const Matrix& right) {
+    checkSameSize(left, right, "Matrix: hadamard: unappropriate arguments");
+    Matrix res(left);
+    zip(res, right, res, [](double x, double y) { return x * y; });
+    return res;
+}
+
+// Blocked sum of count elements: block b covers [b * REDUCTION_BLOCK, ...)
+// whichever thread computes it.
+static double blockedSum(const double* data, size_t count, bool square,
+        size_t num_threads) {
+    size_t blocks = (count + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+    std::vector<double> partial(blocks);
+    ThreadPool::shared().parallelFor(0, blocks,
+        __elementwise_parts(count, num_threads),
+        [data, count, square, &partial](size_t lefti, size_t righti) {
+            forf(b, lefti, righti) {
+                size_t first = b * REDUCTION_BLOCK;
+                size_t len = std::min(REDUCTION_BLOCK, count - first);
+                partial[b] = kernel::sum(data + first, len, square);
+            }
+        });
+    return kernel::pairwiseSum(partial.data(), partial.size());
+}
+
+static double rowSum(const double* row, size_t cols, bool square) {
+    double partial[64];
+    size_t blocks = (cols + REDUCTION_BLOCK - 1) / REDUCTION_BLOCK;
+    if (blocks > 64) {
+        return blockedSum(row, cols, square, 1);
+    }
+    forn(b, blocks) {
+        size_t first = b * REDUCTION_BLOCK;
+        partial[b] = kernel::sum(row + first,
+            std::min(REDUCTION_BLOCK, cols - first), square);
+    }
+    return kernel::pairwiseSum(partial, blocks);
+}
+
+static Vector rowReduce(const Matrix& m, bool square) {
+    Vector res(m.Rows());
+    size_t cols = m.Cols();
+    ThreadPool::shared().parallelFor(0, m.Rows(),
+        __elementwise_parts(m.Rows() * cols, m.Threads()),
+        [&m, &res, cols, square](size_t lefti, size_t righti) {
+            forf(i, lefti, righti) {
+                res[i] = rowSum(m[i], cols, square);
+            }
+        });
+    return res;
+}
+
+// Each thread owns a stripe of columns and adds rows in ascending order,
+// so the order of additions per column is fixed. The sums are kept in
+// line-aligned stripes and copied out at the end.
+static Vector colReduce(const Matrix& m, bool square) {
+    size_t cols = m.Cols();
+    size_t stripes = (cols + COLUMN_STRIPE - 1) / COLUMN_STRIPE;
+    std::vector<__column_stripe> acc(stripes, __column_stripe{});
+    ThreadPool::shared().parallelFor(0, stripes,
+        __elementwise_parts(m.Rows() * cols, m.Threads()),
+        [&m, &acc, cols, square](size_t lefti, size_t righti) {
+            forn(i, m.Rows()) {
+                const double* row = m[i];
+                forf(st, lefti, righti) {
+                    double* sums = acc[st].sums;
+                    size_t c0 = st * COLUMN_STRIPE;
+                    size_t width = std::min(COLUMN_STRIPE, cols - c0);
+                    forn(j, width) {
+                        double x = row[c0 + j];
+                        sums[j] += square ? x * x : x;
+                    }
+                }
+            }
+        });
+    Vector res(cols);
+    forn(j, cols) {
+        res[j] = acc[j / COLUMN_STRIPE].sums[j % COLUMN_STRIPE];
+    }
+    return res;
+}
+
+double sum(const Matrix& m) {
+    return blockedSum(m.Data(), m.Rows() * m.Cols(), false, m.Threads());
+}
+
+Vector rowSums(const Matrix& m) {
+    return rowReduce(m, false);
+}
+
+Vector colSums(const Matrix& m) {
+    return colReduce(m, false);
+}
+
+double norm(const Matrix& m) {
+    return std::sqrt(blockedSum(m.Data(), m.Rows() * m.Cols(), true,
+        m.Threads()));
+}
+
+Vector rowNorms(const Matrix& m) {
+    Vector res = rowReduce(m, true);
+    for (double& x : res) {
+        x = std::sqrt(x);
+    }
+    return res;
+}
+
+Vector colNorms(const Matrix& m) {
+    Vector res = colReduce(m, true);
+    for (double& x : res) {
+        x = std::sqrt(x);
+    }
+    return res;
+}
+
+double maxAbs(const Matrix& m) {
+    const double* data = m.Data();
+    size_t count = m.Rows() * m.Cols();
+    size_t parts = __elementwise_parts(count, m.Threads());
+    std::vector<double> partial(parts, 0.0);
+    size_t chunk = count / parts;
+    ThreadPool::shared().parallelFor(0, count, parts,
+        [data, chunk, &partial](size_t lefti, size_t righti) {
+            double res = 0.0;
+            bool nan = false;
+            forf(i, lefti, righti) {
+                double x = std::fabs(data[i]);
+                res = std::max(res, x);
+                nan = nan || std::isnan(x);
+            }
+            partial[lefti / chunk] = nan ?
+                std::numeric_limits<double>::quiet_NaN() : res;
+        });
+    double res = 0.0;
+    for (double x : partial) {
+        if (std::isnan(x)) {
+            return x;
+        }
+        res = std::max(res, x);
+    }
+    return res;
+}
+
+}  // namespace matrix
+
+#undef forn
+#undef forf
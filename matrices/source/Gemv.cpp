@@ -0,0 +1,97 @@
+#include "Matrix.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+#define forf(i, n1, n2) for (size_t i = size_t(n1); i < size_t(n2); ++i)
+
+namespace matrix {
+
+// Below this many elements a single thread beats waking the pool.
+static const size_t GEMV_PARALLEL_MIN = 1 << 15;
+
+// Column stripes of A^T * x are whole cache lines of y, counted from the
+// line y starts in, so threads never write to the same line of y.
+static const size_t GEMV_STRIPE = 8;
+
+// Rows of A per block in gemvBatched, about 256 KiB of A.
+static const size_t GEMV_BATCH_BYTES = 1 << 18;
+
+static size_t gemvParts(const Matrix& a) {
+    return a.Rows() * a.Cols() < GEMV_PARALLEL_MIN ? 1 : a.Threads();
+}
+
+void gemv(const Matrix& a, const double* x, double* y) {
+    ThreadPool::shared().parallelFor(0, a.Rows(), gemvParts(a),
+        [&a, x, y](size_t lefti, size_t righti) {
+            kernel::gemvRows(a.Data(), a.Cols(), x, y,
+                lefti, righti, a.Cols());
+        });
+}
+
+void gemvTransposed(const Matrix& a, const double* x, double* y) {
+    // Elements of y's first line that come before y itself.
+    size_t shift = reinterpret_cast<uintptr_t>(y) / sizeof(double) %
+        GEMV_STRIPE;
+    size_t stripes = (a.Cols() + shift + GEMV_STRIPE - 1) / GEMV_STRIPE;
+    ThreadPool::shared().parallelFor(0, stripes, gemvParts(a),
+        [&a, x, y, shift](size_t lefti, size_t righti) {
+            kernel::gemvTransposedCols(a.Data(), a.Cols(), x, y,
+                std::max(lefti * GEMV_STRIPE, shift) - shift,
+                std::min(righti * GEMV_STRIPE - shift, a.Cols()), a.Rows());
+        });
+}
+
+Vector operator*(const Matrix& a, const Vector& x) {
+    if (a.Cols() != x.size()) {
+        throw "Matrix: operator*: unappropriate arguments";
+    }
+    Vector y(a.Rows());
+    gemv(a, x.data(), y.data());
+    return y;
+}
+
+Vector multiplyTransposed(const Matrix& a, const Vector& x) {
+    if (a.Rows() != x.size()) {
+        throw "Matrix: multiplyTransposed: unappropriate arguments";
+    }
+    Vector y(a.Cols());
+    gemvTransposed(a, x.data(), y.data());
+    return y;
+}
+
+void gemvBatched(const Matrix& a, const Matrix& xs, Matrix& ys) {
+    if (a.Cols() != xs.Cols()) {
+        throw "Matrix: gemvBatched: unappropriate arguments";
+    }
+    if (&ys == &a || &ys == &xs) {
+        throw "Matrix: gemvBatched: result aliases an argument";
+    }
+    ys.resize(xs.Rows(), a.Rows());
+    size_t block = std::max<size_t>(1,
+        GEMV_BATCH_BYTES / (sizeof(double) * std::max<size_t>(1, a.Cols())));
+    size_t parts = a.Rows() * a.Cols() * xs.Rows() < GEMV_PARALLEL_MIN ?
+        1 : a.Threads();
+    ThreadPool::shared().parallelFor(0, a.Rows(), parts,
+        [&a, &xs, &ys, block](size_t lefti, size_t righti) {
+            for (size_t ib = lefti; ib < righti; ib += block) {
+                size_t ie = std::min(ib + block, righti);
+                forn(v, xs.Rows()) {
+                    const double* x = xs[v];
+                    double* y = ys[v];
+                    forf(i, ib, ie) {
+                        y[i] = kernel::dot(a[i], x, a.Cols());
+                    }
+                }
+            }
+        });
+}
+
+}  // namespace matrix
+
+#undef forn
+#undef forf
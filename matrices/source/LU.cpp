@@ -0,0 +1,272 @@
+#include "LU.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+#define forf(i, n1, n2) for (size_t i = size_t(n1); i < size_t(n2); ++i)
+
+namespace matrix {
+
+// Column stripes are cut at multiples of this many columns. Matrix storage
+// starts on a cache line, so when the order is a multiple of it as well
+// every stripe is made of whole lines and threads never share one; other
+// orders share at most the line at each stripe edge.
+static const size_t LU_STRIPE = 8;
+
+static bool isZero(double x) {
+    return std::fpclassify(x) == FP_ZERO;
+}
+
+// Runs job(c0, c1) over the column stripes of [first, last).
+static void forColumns(size_t first, size_t last, size_t num_threads,
+        size_t rows, const __range_job& job) {
+    size_t base = first / LU_STRIPE * LU_STRIPE;
+    size_t stripes = (last - base + LU_STRIPE - 1) / LU_STRIPE;
+    size_t parts = rows * (last - first) < (1 << 14) ? 1 : num_threads;
+    ThreadPool::shared().parallelFor(0, stripes, parts,
+        [first, last, base, &job](size_t lefti, size_t righti) {
+            job(std::max(first, base + lefti * LU_STRIPE),
+                std::min(base + righti * LU_STRIPE, last));
+        });
+}
+
+LU::LU(const Matrix& a, size_t block) : lu_(a), piv_(a.Rows()),
+        odd_(false), singular_(false) {
+    if (a.Rows() != a.Cols()) {
+        throw "Matrix: LU: unappropriate arguments";
+    }
+    if (block == 0) {
+        block = LU_BLOCK;
+    }
+    size_t n = a.Rows();
+    for (size_t k0 = 0; k0 < n; k0 += block) {
+        size_t kb = std::min(block, n - k0);
+        factorPanel_(k0, kb);
+        if (k0 + kb < n) {
+            solveRowsOfU_(k0, kb);
+            updateTrailing_(k0, kb);
+        }
+    }
+}
+
+// Unblocked LU of columns [k0, k0 + kb), rows [k0, n). Row swaps are
+// applied to whole rows, so L to the left and the trailing matrix follow.
+void LU::factorPanel_(size_t k0, size_t kb) {
+    size_t n = lu_.Rows();
+    double* a = lu_.Data();
+    forf(j, k0, k0 + kb) {
+        size_t p = j;
+        double best = std::fabs(a[j * n + j]);
+        forf(i, j + 1, n) {
+            double cur = std::fabs(a[i * n + j]);
+            if (cur > best) {
+                best = cur;
+                p = i;
+            }
+        }
+        piv_[j] = p;
+        if (p != j) {
+            std::swap_ranges(a + j * n, a + (j + 1) * n, a + p * n);
+            odd_ = !odd_;
+        }
+        double pivot = a[j * n + j];
+        if (isZero(pivot)) {
+            singular_ = true;
+            continue;
+        }
+        forf(i, j + 1, n) {
+            double l = a[i * n + j] / pivot;
+            a[i * n + j] = l;
+            kernel::axpy(-l, a + j * n + j + 1, a + i * n + j + 1,
+                k0 + kb - j - 1);
+        }
+    }
+}
+
+// U12 = L11^-1 * A12 for the rows of the panel, split by column stripes.
+void LU::solveRowsOfU_(size_t k0, size_t kb) {
+    size_t n = lu_.Rows();
+    double* a = lu_.Data();
+    forColumns(k0 + kb, n, lu_.Threads(), kb,
+        [a, n, k0, kb](size_t c0, size_t c1) {
+            forf(i, k0 + 1, k0 + kb) {
+                forf(p, k0, i) {
+                    kernel::axpy(-a[i * n + p], a + p * n + c0,
+                        a + i * n + c0, c1 - c0);
+                }
+            }
+        });
+}
+
+// A22 -= L21 * U12 through the GEMM kernel. L21 is packed negated and U12
+// packed densely, so the kernel only ever accumulates.
+void LU::updateTrailing_(size_t k0, size_t kb) {
+    size_t n = lu_.Rows();
+    size_t first = k0 + kb;
+    size_t rest = n - first;
+    double* a = lu_.Data();
+
+    std::vector<double> l(rest * kb);
+    std::vector<double> u(kb * rest);
+    forn(i, rest) {
+        forn(p, kb) {
+            l[i * kb + p] = -a[(first + i) * n + k0 + p];
+        }
+    }
+    forn(p, kb) {
+        std::copy(a + (k0 + p) * n + first, a + (k0 + p + 1) * n,
+            u.begin() + static_cast<std::ptrdiff_t>(p * rest));
+    }
+
+    const double* lp = l.data();
+    const double* up = u.data();
+    double* c = a + first * n + first;
+    ThreadPool::shared().parallelFor(0, rest, lu_.Threads(),
+        [lp, up, c, n, rest, kb](size_t lefti, size_t righti) {
+            kernel::gemmRows(lp, kb, up, rest, c, n, lefti, righti,
+                rest, kb, true);
+        });
+}
+
+size_t LU::Size() const { return lu_.Rows(); }
+const Matrix& LU::Factors() const { return lu_; }
+const std::vector<size_t>& LU::Pivots() const { return piv_; }
+bool LU::isSingular() const { return singular_; }
+
+double LU::determinant() const {
+    if (singular_) {
+        return 0.0;
+    }
+    double res = odd_ ? -1.0 : 1.0;
+    forn(i, lu_.Rows()) {
+        res *= lu_[i][i];
+    }
+    return res;
+}
+
+// X = U^-1 L^-1 P X, with row operations spread over column stripes of X.
+void LU::solveInPlace_(Matrix& x) const {
+    if (singular_) {
+        throw "Matrix: LU: singular matrix";
+    }
+    size_t n = lu_.Rows();
+    size_t m = x.Cols();
+    const double* a = lu_.Data();
+    double* b = x.Data();
+    forn(i, n) {
+        if (piv_[i] != i) {
+            std::swap_ranges(b + i * m, b + (i + 1) * m, b + piv_[i] * m);
+        }
+    }
+    forColumns(0, m, lu_.Threads(), n * n / std::max<size_t>(1, m),
+        [a, b, n, m](size_t c0, size_t c1) {
+            forn(i, n) {
+                forn(p, i) {
+                    kernel::axpy(-a[i * n + p], b + p * m + c0,
+                        b + i * m + c0, c1 - c0);
+                }
+            }
+            for (size_t i = n; i-- > 0;) {
+                forf(p, i + 1, n) {
+                    kernel::axpy(-a[i * n + p], b + p * m + c0,
+                        b + i * m + c0, c1 - c0);
+                }
+                double d = a[i * n + i];
+                forf(j, c0, c1) {
+                    b[i * m + j] /= d;
+                }
+            }
+        });
+}
+
+Vector LU::solve(const Vector& b) const {
+    if (b.size() != lu_.Rows()) {
+        throw "Matrix: LU: solve: unappropriate arguments";
+    }
+    Matrix x(b.size(), 1, 1);
+    std::copy(b.begin(), b.end(), x.Data());
+    solveInPlace_(x);
+    return Vector(x.Data(), x.Data() + b.size());
+}
+
+Matrix LU::solve(const Matrix& b) const {
+    if (b.Rows() != lu_.Rows()) {
+        throw "Matrix: LU: solve: unappropriate arguments";
+    }
+    Matrix x(b);
+    solveInPlace_(x);
+    return x;
+}
+
+Matrix LU::inverse() const {
+    return solve(Matrix::Identity(lu_.Rows(), lu_.Threads()));
+}
+
+// Substitution restricted to the band of a diagonal or triangular a, with
+// the same column stripes as the LU solve.
+static void solveTriangular(const Matrix& a, Matrix& x) {
+    size_t n = a.Rows();
+    size_t m = x.Cols();
+    const double* t = a.Data();
+    double* b = x.Data();
+    forn(i, n) {
+        if (isZero(t[i * n + i])) {
+            throw "Matrix: solve: singular matrix";
+        }
+    }
+    bool upper = a.structure() == Structure::UpperTriangular;
+    size_t band = std::min(n, upper ? a.UpperBandwidth() :
+        a.LowerBandwidth());
+    forColumns(0, m, a.Threads(), n * (band + 1) / std::max<size_t>(1, m),
+        [t, b, n, m, upper, band](size_t c0, size_t c1) {
+            forn(s, n) {
+                size_t i = upper ? n - 1 - s : s;
+                size_t p0 = upper ? i + 1 : (i > band ? i - band : 0);
+                size_t p1 = upper ? std::min(n, i + band + 1) : i;
+                forf(p, p0, p1) {
+                    kernel::axpy(-t[i * n + p], b + p * m + c0,
+                        b + i * m + c0, c1 - c0);
+                }
+                double d = t[i * n + i];
+                forf(j, c0, c1) {
+                    b[i * m + j] /= d;
+                }
+            }
+        });
+}
+
+Matrix solve(const Matrix& a, const Matrix& b) {
+    if (a.Rows() != a.Cols() || b.Rows() != a.Rows()) {
+        throw "Matrix: solve: unappropriate arguments";
+    }
+    switch (a.structure()) {
+        case Structure::Identity:
+            return b;
+        case Structure::Diagonal:
+        case Structure::UpperTriangular:
+        case Structure::LowerTriangular: {
+            Matrix x(b);
+            solveTriangular(a, x);
+            return x;
+        }
+        default:
+            return LU(a).solve(b);
+    }
+}
+
+Vector solve(const Matrix& a, const Vector& b) {
+    Matrix x(b.size(), 1, 1);
+    std::copy(b.begin(), b.end(), x.Data());
+    x = solve(a, x);
+    return Vector(x.Data(), x.Data() + b.size());
+}
+
+}  // namespace matrix
+
+#undef forn
+#undef forf
@@ -1,23 +1,57 @@
 #include "Matrix.hpp"
 
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
-#include <thread>
+#include <new>
+
+#include "Kernels.hpp"
+#include "Numa.hpp"
+#include "ThreadPool.hpp"
 
 #define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
 #define forf(i, n1, n2) for (size_t i = size_t(n1); i < size_t(n2); ++i)
 
 namespace matrix {
 
-double operator*(const Vector& left, const Vector& right) {
-    if (left.size() != right.size()) {
-        throw "Vector: operator*: unappropriate arguments";
+static const size_t ALIGNMENT = 64;
+
+// From this many bytes buffers come straight from mmap and are first
+// touched in parallel. malloc may hand back pages another thread already
+// touched, which would pin them to that thread's node.
+static const size_t FIRST_TOUCH_MIN = 1 << 20;
+
+// Contents are left unspecified; nothing touches the pages here.
+static std::shared_ptr<double> allocate(size_t count) {
+    size_t bytes = std::max(count * sizeof(double), ALIGNMENT);
+    bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (bytes >= FIRST_TOUCH_MIN) {
+        void* base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        return std::shared_ptr<double>(static_cast<double*>(base),
+            [bytes](double* p) { ::munmap(p, bytes); });
+    }
+    double* raw = static_cast<double*>(std::aligned_alloc(ALIGNMENT, bytes));
+    if (raw == nullptr) {
+        throw std::bad_alloc();
     }
+    return std::shared_ptr<double>(raw, [](double* p) { std::free(p); });
+}
 
-    double res = 0.0;
-    forn(i, left.size()) {
-        res += left[i] * right[i];
+// Runs job over the rows split the way multiply splits them, so each row
+// is first written by the worker that will later compute it and its pages
+// land on that worker's node. Small matrices are done by the caller.
+static void touchRows(size_t rows, size_t cols, size_t num_threads,
+        const __range_job& job) {
+    if (rows * cols * sizeof(double) < FIRST_TOUCH_MIN) {
+        num_threads = 1;
     }
-    return res;
+    ThreadPool::shared().parallelFor(0, rows, num_threads, job);
 }
 
 std::ostream& operator<<(std::ostream& os, const Vector& to_print) {
@@ -30,77 +64,205 @@ std::ostream& operator<<(std::ostream& os, const Vector& to_print) {
 }
 
 Matrix::Matrix(size_t rows, size_t cols, size_t num_threads) :
-    val_(__matrix(rows, Vector(cols, 0))),
-    rows_(rows), cols_(cols), nThreads_(num_threads) {}
+    val_(allocate(rows * cols)), rows_(rows), cols_(cols),
+    capacity_(rows * cols), readOnly_(false), nThreads_(num_threads) {
+    double* data = val_.get();
+    touchRows(rows_, cols_, nThreads_, [data, cols](size_t lefti,
+            size_t righti) {
+        std::fill(data + lefti * cols, data + righti * cols, 0.0);
+    });
+}
 
-Matrix::Matrix(const __matrix& val) : val_(val), rows_(val.size()) {
+Matrix::Matrix(const __matrix& val, size_t num_threads) :
+    rows_(val.size()), readOnly_(false), nThreads_(num_threads) {
     if (rows_ != 0) {
         cols_ = val[0].size();
     } else {
         cols_ = 0;
     }
+    capacity_ = rows_ * cols_;
+    forn(i, rows_) {
+        if (val[i].size() != cols_) {
+            throw "Matrix: Matrix: rows of different length";
+        }
+    }
+    val_ = allocate(capacity_);
+    double* data = val_.get();
+    size_t cols = cols_;
+    touchRows(rows_, cols_, nThreads_, [data, cols, &val](size_t lefti,
+            size_t righti) {
+        forf(i, lefti, righti) {
+            std::copy(val[i].begin(), val[i].end(), data + i * cols);
+        }
+    });
 }
 
-Matrix::Matrix(const Matrix& other) : val_(other.val_), rows_(other.rows_),
-    cols_(other.cols_) {}
+Matrix::Matrix(const Matrix& other) :
+    val_(allocate(other.rows_ * other.cols_)), rows_(other.rows_),
+    cols_(other.cols_), capacity_(rows_ * cols_), readOnly_(false),
+    nThreads_(other.nThreads_) {
+    const double* src = other.Data();
+    double* data = val_.get();
+    size_t cols = cols_;
+    touchRows(rows_, cols_, nThreads_, [src, data, cols](size_t lefti,
+            size_t righti) {
+        std::copy(src + lefti * cols, src + righti * cols, data + lefti * cols);
+    });
+    copyStructure_(other);
+}
+
+Matrix::Matrix(Matrix&& other) noexcept : val_(std::move(other.val_)),
+    rows_(other.rows_), cols_(other.cols_), capacity_(other.capacity_),
+    readOnly_(other.readOnly_), nThreads_(other.nThreads_) {
+    copyStructure_(other);
+    other.rows_ = other.cols_ = other.capacity_ = 0;
+    other.forgetStructure_();
+}
 
 Matrix::~Matrix() {}
 
-Matrix Matrix::operator=(const Matrix& other) {
-    this->val_ = other.val_;
-    this->rows_ = other.rows_;
-    this->cols_ = other.cols_;
-    this->nThreads_ = other.nThreads_;
+Matrix& Matrix::operator=(const Matrix& other) {
+    if (this != &other) {
+        resize(other.rows_, other.cols_);
+        std::copy(other.Data(), other.Data() + rows_ * cols_,
+            mutableData_());
+        this->nThreads_ = other.nThreads_;
+        copyStructure_(other);
+    }
     return *this;
 }
 
+Matrix& Matrix::operator=(Matrix&& other) noexcept {
+    swap(other);
+    return *this;
+}
+
+Matrix Matrix::Identity(size_t n, size_t num_threads) {
+    Matrix res(n, n, num_threads);
+    forn(i, n) {
+        res[i][i] = 1.0;
+    }
+    res.setStructure(Structure::Identity);
+    return res;
+}
+
+Matrix Matrix::View(std::shared_ptr<double> buf, size_t rows, size_t cols,
+        bool read_only, size_t num_threads) {
+    Matrix res(0, 0, num_threads);
+    res.val_ = std::move(buf);
+    res.rows_ = rows;
+    res.cols_ = cols;
+    res.capacity_ = rows * cols;
+    res.readOnly_ = read_only;
+    return res;
+}
+
 __m_size_t Matrix::Size() const { return __m_size_t(rows_, cols_); }
 size_t Matrix::Rows() const { return rows_; }
 size_t Matrix::Cols() const { return cols_; }
+size_t Matrix::Threads() const { return nThreads_; }
+bool Matrix::ReadOnly() const { return readOnly_; }
 
-Vector& Matrix::operator[](size_t i) { return val_[i]; }
-Vector Matrix::operator[](size_t i) const { return val_[i]; }
+void Matrix::setThreads(size_t num_threads) {
+    nThreads_ = num_threads == 0 ? 1 : num_threads;
+}
 
-Matrix Matrix::computeTransposed() const {
-    __matrix res(cols_, Vector(rows_, 0));
-    forn(i, rows_) {
-        forn(j, cols_) {
-            res[j][i] = val_[i][j];
-        }
+double* Matrix::operator[](size_t i) { return mutableData_() + i * cols_; }
+const double* Matrix::operator[](size_t i) const {
+    return val_.get() + i * cols_;
+}
+
+double* Matrix::Data() { return mutableData_(); }
+const double* Matrix::Data() const { return val_.get(); }
+
+double* Matrix::mutableData_() {
+    if (readOnly_) {
+        throw "Matrix: read-only view";
     }
-    return Matrix(res);
+    forgetStructure_();
+    return val_.get();
 }
 
-void threadMultiplyJob(Matrix::__thr_m_j_input in) {
-    forf(i, in.lefti, in.righti) {
-        forn(j, in.tright.Rows()) {
-            in.res[i][j] = in.left[i] * in.tright[j];
-        }
+std::vector<int> Matrix::rowNodes() const {
+    std::vector<const void*> pages(rows_);
+    forn(i, rows_) {
+        pages[i] = val_.get() + i * cols_;
     }
+    return numa::pageNodes(pages);
 }
 
-Matrix operator*(const Matrix& left, const Matrix& right) {
-    __matrix res(left.rows_, Vector(right.cols_, 0));
-    const Matrix tright = right.computeTransposed();
-    std::vector<std::thread> threads;
-    forn(i, left.nThreads_) {
-        size_t lefti = i * (res.size() / left.nThreads_);
-        size_t righti = i == left.nThreads_ - 1 ?
-                res.size() : (i + 1) * (res.size() / left.nThreads_);
-        Matrix::__thr_m_j_input in = {left, tright, lefti, righti, res};
-        threads.push_back(std::thread(&threadMultiplyJob, in));
+// A new buffer is not filled, so its pages are placed by whoever writes
+// them first, normally the workers of the next multiply into it.
+void Matrix::resize(size_t rows, size_t cols) {
+    if (rows * cols > capacity_ || readOnly_) {
+        val_ = allocate(rows * cols);
+        capacity_ = rows * cols;
+        readOnly_ = false;
     }
+    rows_ = rows;
+    cols_ = cols;
+    forgetStructure_();
+}
+
+void Matrix::swap(Matrix& other) noexcept {
+    std::swap(val_, other.val_);
+    std::swap(rows_, other.rows_);
+    std::swap(cols_, other.cols_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(readOnly_, other.readOnly_);
+    std::swap(nThreads_, other.nThreads_);
+    int structure = structure_.load(std::memory_order_relaxed);
+    size_t lower = lower_.load(std::memory_order_relaxed);
+    size_t upper = upper_.load(std::memory_order_relaxed);
+    copyStructure_(other);
+    other.lower_.store(lower, std::memory_order_relaxed);
+    other.upper_.store(upper, std::memory_order_relaxed);
+    other.structure_.store(structure, std::memory_order_release);
+}
 
-    forn(i, left.nThreads_) {
-        threads[i].join();
+bool Matrix::isDiagonal() const {
+    Structure s = structure();
+    return s == Structure::Diagonal || s == Structure::Identity;
+}
+
+bool Matrix::isIdentity() const {
+    return structure() == Structure::Identity;
+}
+
+void threadMultiplyJob(Matrix::__thr_m_j_input in) {
+    kernel::gemmRows(in.left.Data(), in.left.Cols(),
+        in.right.Data(), in.right.Cols(), in.res.Data(), in.res.Cols(),
+        in.lefti, in.righti, in.right.Cols(), in.left.Cols());
+}
+
+void multiply(const Matrix& left, const Matrix& right, Matrix& res) {
+    if (left.Cols() != right.Rows()) {
+        throw "Matrix: multiply: unappropriate arguments";
     }
-    return Matrix(res);
+    if (&res == &left || &res == &right) {
+        throw "Matrix: multiply: result aliases an argument";
+    }
+    if (multiplyStructured(left, right, res)) {
+        return;
+    }
+    res.resize(left.Rows(), right.Cols());
+    ThreadPool::shared().parallelFor(0, left.Rows(), left.Threads(),
+        [&left, &right, &res](size_t lefti, size_t righti) {
+            Matrix::__thr_m_j_input in = {left, right, lefti, righti, res};
+            threadMultiplyJob(in);
+        });
+}
+
+Matrix operator*(const Matrix& left, const Matrix& right) {
+    Matrix res(left.rows_, right.cols_, left.nThreads_);
+    multiply(left, right, res);
+    return res;
 }
 
-std::ostream& operator<<(std::ostream& os, Matrix to_print) {
+std::ostream& operator<<(std::ostream& os, const Matrix& to_print) {
     os << "[" << std::endl;
     forn(i, to_print.Rows()) {
-        os << to_print[i] << std::endl;
+        os << Vector(to_print[i], to_print[i] + to_print.Cols()) << std::endl;
     }
     os << "]";
     return os;
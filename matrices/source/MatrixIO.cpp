@@ -0,0 +1,372 @@
+#include "MatrixIO.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+#define forf(i, n1, n2) for (size_t i = size_t(n1); i < size_t(n2); ++i)
+
+namespace matrix {
+
+// Large enough to keep the disk streaming, small enough not to matter
+// next to the matrix itself.
+static const size_t IO_CHUNK = size_t(64) << 20;
+
+static void writeAll(int fd, const char* data, size_t count) {
+    while (count != 0) {
+        ssize_t done = ::write(fd, data, std::min(count, IO_CHUNK));
+        if (done < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw "Matrix: writeBinary: write failed";
+        }
+        data += done;
+        count -= static_cast<size_t>(done);
+    }
+}
+
+static void readAll(int fd, char* data, size_t count, off_t offset) {
+    while (count != 0) {
+        ssize_t done = ::pread(fd, data, std::min(count, IO_CHUNK), offset);
+        if (done < 0 && errno == EINTR) {
+            continue;
+        }
+        if (done <= 0) {
+            throw "Matrix: readBinary: unexpected end of file";
+        }
+        data += done;
+        count -= static_cast<size_t>(done);
+        offset += done;
+    }
+}
+
+// Bytes of element data the header describes, refused when it or the end
+// of the data would not fit in a file offset.
+static size_t dataBytes(const __m_file_header& header) {
+    const uint64_t limit =
+        static_cast<uint64_t>(std::numeric_limits<off_t>::max());
+    if (header.dataOffset > limit) {
+        throw "Matrix: readHeader: corrupted header";
+    }
+    uint64_t room = (limit - header.dataOffset) / sizeof(double);
+    if (header.rows != 0 && header.cols > room / header.rows) {
+        throw "Matrix: readHeader: corrupted header";
+    }
+    return static_cast<size_t>(header.rows * header.cols * sizeof(double));
+}
+
+// Reads and validates the header: the data must start at a multiple of the
+// recorded alignment, itself a multiple of the element size, so mapped data
+// is aligned, and the file must be long enough to hold all of it.
+static __m_file_header checkedHeader(int fd) {
+    __m_file_header header;
+    readAll(fd, reinterpret_cast<char*>(&header), sizeof(header), 0);
+    if (std::memcmp(header.magic, M_FILE_MAGIC, sizeof(M_FILE_MAGIC)) != 0) {
+        throw "Matrix: readHeader: not a matrix file";
+    }
+    if (header.version != M_FILE_VERSION ||
+            header.dtype != M_DTYPE_F64_LE) {
+        throw "Matrix: readHeader: unsupported version or element type";
+    }
+    if (header.dataOffset < sizeof(header) || header.alignment == 0 ||
+            header.alignment % sizeof(double) != 0 ||
+            header.dataOffset % header.alignment != 0) {
+        throw "Matrix: readHeader: corrupted header";
+    }
+    size_t length = header.dataOffset + dataBytes(header);
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < length) {
+        throw "Matrix: readHeader: unexpected end of file";
+    }
+    return header;
+}
+
+static __m_file_header makeHeader(size_t rows, size_t cols) {
+    __m_file_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, M_FILE_MAGIC, sizeof(M_FILE_MAGIC));
+    header.version = M_FILE_VERSION;
+    header.dtype = M_DTYPE_F64_LE;
+    header.rows = rows;
+    header.cols = cols;
+    header.alignment = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+    header.dataOffset = header.alignment;
+    return header;
+}
+
+// Opens `path` for writing and fills the first page with the header.
+static int startBinary(const std::string& path, size_t rows, size_t cols,
+        __m_file_header* header) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw "Matrix: writeBinary: cannot open file";
+    }
+    *header = makeHeader(rows, cols);
+    try {
+        std::vector<char> head(header->dataOffset, 0);
+        std::memcpy(head.data(), header, sizeof(*header));
+        writeAll(fd, head.data(), head.size());
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    return fd;
+}
+
+void writeBinary(const Matrix& m, const std::string& path) {
+    __m_file_header header;
+    int fd = startBinary(path, m.Rows(), m.Cols(), &header);
+    try {
+        writeAll(fd, reinterpret_cast<const char*>(m.Data()),
+            m.Rows() * m.Cols() * sizeof(double));
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    if (::close(fd) != 0) {
+        throw "Matrix: writeBinary: write failed";
+    }
+}
+
+void createBinary(const std::string& path, size_t rows, size_t cols) {
+    __m_file_header header;
+    int fd = startBinary(path, rows, cols, &header);
+    off_t length = static_cast<off_t>(header.dataOffset +
+        rows * cols * sizeof(double));
+    if (::ftruncate(fd, length) != 0) {
+        ::close(fd);
+        throw "Matrix: createBinary: cannot resize file";
+    }
+    if (::close(fd) != 0) {
+        throw "Matrix: createBinary: write failed";
+    }
+}
+
+__m_file_header readHeader(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw "Matrix: readHeader: cannot open file";
+    }
+    try {
+        __m_file_header header = checkedHeader(fd);
+        ::close(fd);
+        return header;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+Matrix readBinary(const std::string& path, size_t num_threads) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw "Matrix: readBinary: cannot open file";
+    }
+    try {
+        __m_file_header header = checkedHeader(fd);
+        Matrix res(0, 0, num_threads);
+        res.resize(header.rows, header.cols);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        readAll(fd, reinterpret_cast<char*>(res.Data()), dataBytes(header),
+            static_cast<off_t>(header.dataOffset));
+        ::close(fd);
+        return res;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+Matrix mapBinary(const std::string& path, Access advice,
+        size_t num_threads) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw "Matrix: mapBinary: cannot open file";
+    }
+    __m_file_header header;
+    try {
+        header = checkedHeader(fd);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    size_t length = header.dataOffset + dataBytes(header);
+    void* base = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        throw "Matrix: mapBinary: mmap failed";
+    }
+
+    int flag = MADV_NORMAL;
+    switch (advice) {
+        case Access::Sequential: flag = MADV_SEQUENTIAL; break;
+        case Access::Random: flag = MADV_RANDOM; break;
+        case Access::WillNeed: flag = MADV_WILLNEED; break;
+        default: break;
+    }
+    ::madvise(base, length, flag);
+
+    char* bytes = static_cast<char*>(base);
+    std::shared_ptr<double> buf(
+        reinterpret_cast<double*>(bytes + header.dataOffset),
+        [base, length](double*) { ::munmap(base, length); });
+    return Matrix::View(buf, header.rows, header.cols, true, num_threads);
+}
+
+void writeText(const Matrix& m, const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw "Matrix: writeText: cannot open file";
+    }
+    out << m.Rows() << " " << m.Cols() << "\n";
+
+    // Rows are formatted in batches of a few MiB so memory stays bounded
+    // while every worker has something to do.
+    size_t batch = std::max<size_t>(m.Threads(),
+        (size_t(4) << 20) / (24 * std::max<size_t>(1, m.Cols())));
+    std::vector<std::string> lines(batch);
+    for (size_t first = 0; first < m.Rows(); first += batch) {
+        size_t last = std::min(first + batch, m.Rows());
+        ThreadPool::shared().parallelFor(first, last, m.Threads(),
+            [&m, &lines, first](size_t lefti, size_t righti) {
+                char number[32];
+                forf(i, lefti, righti) {
+                    std::string& line = lines[i - first];
+                    line.clear();
+                    forn(j, m.Cols()) {
+                        int len = std::snprintf(number, sizeof(number),
+                            j + 1 == m.Cols() ? "%.17g\n" : "%.17g ",
+                            m[i][j]);
+                        line.append(number, static_cast<size_t>(len));
+                    }
+                    if (m.Cols() == 0) {
+                        line.push_back('\n');
+                    }
+                }
+            });
+        forf(i, first, last) {
+            out << lines[i - first];
+        }
+    }
+    if (!out) {
+        throw "Matrix: writeText: write failed";
+    }
+}
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Parses exactly `cols` numbers from [p, end), a line without its newline.
+// strtod would skip any whitespace, the newline at `end` included, and read
+// on into the next row, so each number must start right after the blanks.
+static bool parseRow(const char* p, const char* end, double* row,
+        size_t cols) {
+    forn(j, cols) {
+        while (p != end && isBlank(*p)) {
+            ++p;
+        }
+        if (p == end || std::isspace(static_cast<unsigned char>(*p))) {
+            return false;
+        }
+        char* next = nullptr;
+        row[j] = std::strtod(p, &next);
+        if (next == p || next > end) {
+            return false;
+        }
+        p = next;
+    }
+    while (p != end && isBlank(*p)) {
+        ++p;
+    }
+    return p == end;
+}
+
+Matrix readText(const std::string& path, size_t num_threads) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw "Matrix: readText: cannot open file";
+    }
+    std::string text(static_cast<size_t>(in.tellg()), '\0');
+    in.seekg(0);
+    if (!in.read(&text[0], static_cast<std::streamsize>(text.size()))) {
+        throw "Matrix: readText: read failed";
+    }
+
+    size_t rows = 0;
+    size_t cols = 0;
+    int consumed = 0;
+    if (std::sscanf(text.c_str(), "%zu %zu%n", &rows, &cols, &consumed) != 2) {
+        throw "Matrix: readText: malformed header";
+    }
+    // Every row takes a line and every element at least two bytes.
+    if (rows > text.size() || (cols != 0 && rows > text.size() / 2 / cols)) {
+        throw "Matrix: readText: unexpected end of file";
+    }
+
+    // Row i is the text in [starts[i], starts[i + 1] - 1).
+    std::vector<size_t> starts(rows + 1);
+    size_t pos = text.find('\n', static_cast<size_t>(consumed));
+    if (pos == std::string::npos && rows != 0) {
+        throw "Matrix: readText: unexpected end of file";
+    }
+    forf(c, static_cast<size_t>(consumed), std::min(pos, text.size())) {
+        if (!isBlank(text[c])) {
+            throw "Matrix: readText: malformed header";
+        }
+    }
+    forn(i, rows) {
+        if (pos == std::string::npos) {
+            throw "Matrix: readText: unexpected end of file";
+        }
+        starts[i] = pos + 1;
+        pos = text.find('\n', pos + 1);
+    }
+    starts[rows] = pos == std::string::npos ? text.size() + 1 : pos + 1;
+    forf(c, starts[rows], text.size()) {
+        if (!isBlank(text[c]) && text[c] != '\n') {
+            throw "Matrix: readText: trailing data after the last row";
+        }
+    }
+
+    Matrix res(0, 0, num_threads);
+    res.resize(rows, cols);
+    double* data = res.Data();
+    const char* base = text.c_str();
+    std::atomic<bool> bad(false);
+    ThreadPool::shared().parallelFor(0, rows, num_threads,
+        [data, base, cols, &starts, &bad](size_t lefti, size_t righti) {
+            forf(i, lefti, righti) {
+                if (!parseRow(base + starts[i], base + starts[i + 1] - 1,
+                        data + i * cols, cols)) {
+                    bad = true;
+                    return;
+                }
+            }
+        });
+    if (bad) {
+        throw "Matrix: readText: malformed row";
+    }
+    return res;
+}
+
+}  // namespace matrix
+
+#undef forn
+#undef forf
@@ -0,0 +1,148 @@
+#include "Numa.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+
+namespace matrix {
+
+namespace numa {
+
+static const int MAX_NODES = 64;
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}; node lists use the same form.
+static std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> res;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty() || item[0] == '\n') {
+            continue;
+        }
+        size_t dash = item.find('-');
+        int first = std::stoi(item.substr(0, dash));
+        int last = dash == std::string::npos ? first :
+            std::stoi(item.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            res.push_back(cpu);
+        }
+    }
+    return res;
+}
+
+// cpus[node], empty for nodes that do not exist or have no CPUs.
+static const std::vector<std::vector<int>>& topology() {
+    static const std::vector<std::vector<int>> nodes = []() {
+        std::vector<std::vector<int>> res;
+        for (int node = 0; node < MAX_NODES; ++node) {
+            std::ifstream in("/sys/devices/system/node/node" +
+                std::to_string(node) + "/cpulist");
+            std::string list;
+            if (!in || !std::getline(in, list)) {
+                continue;
+            }
+            res.resize(static_cast<size_t>(node) + 1);
+            res[static_cast<size_t>(node)] = parseCpuList(list);
+        }
+        return res;
+    }();
+    return nodes;
+}
+
+size_t nodeCount() {
+    size_t res = 0;
+    for (const std::vector<int>& cpus : topology()) {
+        if (!cpus.empty()) {
+            ++res;
+        }
+    }
+    return std::max<size_t>(res, 1);
+}
+
+std::vector<int> onlineNodes() {
+    std::ifstream in("/sys/devices/system/node/online");
+    std::string list;
+    std::vector<int> res;
+    if (in && std::getline(in, list)) {
+        res = parseCpuList(list);
+    }
+    if (res.empty()) {
+        res.push_back(0);
+    }
+    return res;
+}
+
+int nodeOfCpu(int cpu) {
+    const std::vector<std::vector<int>>& nodes = topology();
+    forn(node, nodes.size()) {
+        if (std::find(nodes[node].begin(), nodes[node].end(), cpu) !=
+                nodes[node].end()) {
+            return static_cast<int>(node);
+        }
+    }
+    return 0;
+}
+
+std::vector<int> placementCpus() {
+    std::vector<int> res;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return res;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            res.push_back(cpu);
+        }
+    }
+    std::stable_sort(res.begin(), res.end(), [](int a, int b) {
+        return nodeOfCpu(a) < nodeOfCpu(b);
+    });
+    return res;
+}
+
+bool pinThread(std::thread& thread, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set),
+        &set) == 0;
+}
+
+std::vector<int> pageNodes(const std::vector<const void*>& pages) {
+    std::vector<int> res(pages.size(), -1);
+    if (pages.empty()) {
+        return res;
+    }
+#ifdef SYS_move_pages
+    // With no target nodes move_pages only reports where each page lives:
+    // a node number, or a negative errno such as -ENOENT for a page that
+    // has never been touched.
+    std::vector<void*> addrs(pages.size());
+    forn(i, pages.size()) {
+        addrs[i] = const_cast<void*>(pages[i]);
+    }
+    std::vector<int> status(pages.size(), -1);
+    if (syscall(SYS_move_pages, 0, addrs.size(), addrs.data(), nullptr,
+            status.data(), 0) == 0) {
+        forn(i, status.size()) {
+            res[i] = status[i] < 0 ? -1 : status[i];
+        }
+    }
+#endif
+    return res;
+}
+
+}  // namespace numa
+
+}  // namespace matrix
+
+#undef forn
@@ -0,0 +1,96 @@
+#include "Matrix.hpp"
+
+#include <algorithm>
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+
+namespace matrix {
+
+// Same multiplication order as the dense loop in pow(), so a diagonal input
+// gives bit-identical results through either path.
+static double scalarPow(double x, size_t k) {
+    double res = 1.0;
+    bool started = false;
+    for (;;) {
+        if (k & 1) {
+            res = started ? res * x : x;
+            started = true;
+        }
+        k >>= 1;
+        if (k == 0) {
+            break;
+        }
+        x *= x;
+    }
+    return res;
+}
+
+Matrix pow(const Matrix& base, size_t k) {
+    if (base.Rows() != base.Cols()) {
+        throw "Matrix: pow: unappropriate arguments";
+    }
+    size_t n = base.Rows();
+    if (k == 0 || base.isIdentity()) {
+        return Matrix::Identity(n, base.Threads());
+    }
+    if (base.isDiagonal()) {
+        Matrix res(n, n, base.Threads());
+        forn(i, n) {
+            res[i][i] = scalarPow(base[i][i], k);
+        }
+        return res;
+    }
+
+    Matrix res(n, n, base.Threads());
+    Matrix sq(base);
+    Matrix tmp(n, n, base.Threads());
+    bool started = false;
+    for (;;) {
+        if (k & 1) {
+            if (started) {
+                multiply(res, sq, tmp);
+                res.swap(tmp);
+            } else {
+                std::copy(sq.Data(), sq.Data() + n * n, res.Data());
+                started = true;
+            }
+        }
+        k >>= 1;
+        if (k == 0) {
+            break;
+        }
+        multiply(sq, sq, tmp);
+        sq.swap(tmp);
+    }
+    return res;
+}
+
+Matrix squareRepeated(const Matrix& base, size_t times) {
+    if (base.Rows() != base.Cols()) {
+        throw "Matrix: squareRepeated: unappropriate arguments";
+    }
+    size_t n = base.Rows();
+    Matrix res(base);
+    if (times == 0 || base.isIdentity()) {
+        return res;
+    }
+    if (base.isDiagonal()) {
+        forn(i, n) {
+            forn(t, times) {
+                res[i][i] *= res[i][i];
+            }
+        }
+        return res;
+    }
+
+    Matrix tmp(n, n, base.Threads());
+    forn(t, times) {
+        multiply(res, res, tmp);
+        res.swap(tmp);
+    }
+    return res;
+}
+
+}  // namespace matrix
+
+#undef forn
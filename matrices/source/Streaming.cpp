@@ -0,0 +1,271 @@
+#include "Streaming.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "Kernels.hpp"
+#include "MatrixIO.hpp"
+#include "ThreadPool.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+
+namespace matrix {
+
+// A file opened for block I/O on its row-major data.
+class __m_block_file {
+    public:
+        __m_block_file(const std::string& path, int flags) :
+                header_(readHeader(path)),
+                fd_(::open(path.c_str(), flags)) {
+            if (fd_ < 0) {
+                throw "Matrix: multiplyFiles: cannot open file";
+            }
+        }
+
+        __m_block_file(const __m_block_file& other) = delete;
+        __m_block_file& operator=(const __m_block_file& other) = delete;
+
+        ~__m_block_file() {
+            ::close(fd_);
+        }
+
+        size_t Rows() const { return header_.rows; }
+        size_t Cols() const { return header_.cols; }
+
+        // Rows [r0, r1) and columns [c0, c1) to or from a densely packed
+        // buffer, one syscall per row.
+        void read(double* buf, size_t r0, size_t r1, size_t c0, size_t c1) {
+            for (size_t i = r0; i < r1; ++i) {
+                transfer(buf + (i - r0) * (c1 - c0), i, c0, c1, false);
+            }
+        }
+
+        void write(const double* buf, size_t r0, size_t r1, size_t c0,
+                size_t c1) {
+            for (size_t i = r0; i < r1; ++i) {
+                transfer(const_cast<double*>(buf + (i - r0) * (c1 - c0)),
+                    i, c0, c1, true);
+            }
+        }
+
+    private:
+        __m_file_header header_;
+        int fd_;
+
+        void transfer(double* row, size_t i, size_t c0, size_t c1,
+                bool out) {
+            char* data = reinterpret_cast<char*>(row);
+            size_t count = (c1 - c0) * sizeof(double);
+            off_t offset = static_cast<off_t>(header_.dataOffset +
+                (i * header_.cols + c0) * sizeof(double));
+            while (count != 0) {
+                ssize_t done = out ? ::pwrite(fd_, data, count, offset) :
+                    ::pread(fd_, data, count, offset);
+                if (done < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (done <= 0) {
+                    throw "Matrix: multiplyFiles: I/O failed";
+                }
+                data += done;
+                count -= static_cast<size_t>(done);
+                offset += done;
+            }
+        }
+};
+
+struct __m_block {
+    size_t i;
+    size_t j;
+    size_t p;
+};
+
+// Double-buffered state shared by the compute thread and the I/O thread.
+// Input slot s holds the blocks of step s % 2, output slot holds the C
+// block of the (i, j) pair it was last handed.
+struct __m_stream_state {
+    std::mutex lock;
+    std::condition_variable cv;
+
+    std::vector<double> a[2];
+    std::vector<double> b[2];
+    bool filled[2];
+
+    std::vector<double> c[2];
+    bool pending[2];
+    __m_block written[2];
+
+    bool stop;
+    std::exception_ptr error;
+};
+
+void multiplyFiles(const std::string& a_path, const std::string& b_path,
+        const std::string& c_path, size_t memory_budget, size_t num_threads) {
+    __m_block_file fa(a_path, O_RDONLY);
+    __m_block_file fb(b_path, O_RDONLY);
+    if (fa.Cols() != fb.Rows()) {
+        throw "Matrix: multiplyFiles: unappropriate arguments";
+    }
+    size_t m = fa.Rows();
+    size_t n = fb.Cols();
+    size_t k = fa.Cols();
+    // Creating C truncates it, so it must not be either input under any
+    // name. A C that does not exist yet compares unequal.
+    std::error_code ec;
+    if (std::filesystem::equivalent(c_path, a_path, ec) ||
+            std::filesystem::equivalent(c_path, b_path, ec)) {
+        throw "Matrix: multiplyFiles: result aliases an argument";
+    }
+    createBinary(c_path, m, n);
+    if (m == 0 || n == 0) {
+        return;
+    }
+    __m_block_file fc(c_path, O_WRONLY);
+
+    // Six blocks of s * s doubles: two of each operand.
+    size_t s = static_cast<size_t>(std::sqrt(static_cast<double>(
+        memory_budget / (6 * sizeof(double)))));
+    if (s == 0) {
+        throw "Matrix: multiplyFiles: memory budget too small";
+    }
+    size_t mb = std::min(m, s);
+    size_t nb = std::min(n, s);
+    size_t kb = std::max<size_t>(1, std::min(k, s));
+
+    std::vector<__m_block> steps;
+    for (size_t j = 0; j < n; j += nb) {
+        for (size_t i = 0; i < m; i += mb) {
+            for (size_t p = 0; p < std::max<size_t>(k, 1); p += kb) {
+                steps.push_back(__m_block{i, j, p});
+            }
+        }
+    }
+
+    __m_stream_state st;
+    forn(t, 2) {
+        st.a[t].resize(mb * kb);
+        st.b[t].resize(kb * nb);
+        st.c[t].resize(mb * nb);
+        st.filled[t] = false;
+        st.pending[t] = false;
+    }
+    st.stop = false;
+
+    std::thread io([&]() {
+        size_t next = 0;
+        try {
+            for (;;) {
+                std::unique_lock<std::mutex> guard(st.lock);
+                st.cv.wait(guard, [&]() {
+                    return st.stop || st.pending[0] || st.pending[1] ||
+                        (next < steps.size() && !st.filled[next % 2]);
+                });
+                int out = st.pending[0] ? 0 : (st.pending[1] ? 1 : -1);
+                if (out >= 0) {
+                    __m_block blk = st.written[out];
+                    guard.unlock();
+                    fc.write(st.c[out].data(), blk.i, std::min(blk.i + mb, m),
+                        blk.j, std::min(blk.j + nb, n));
+                    guard.lock();
+                    st.pending[out] = false;
+                    st.cv.notify_all();
+                    continue;
+                }
+                if (st.stop) {
+                    return;
+                }
+                size_t slot = next % 2;
+                __m_block blk = steps[next];
+                guard.unlock();
+                size_t i1 = std::min(blk.i + mb, m);
+                size_t j1 = std::min(blk.j + nb, n);
+                size_t p1 = std::min(blk.p + kb, k);
+                fa.read(st.a[slot].data(), blk.i, i1, blk.p, p1);
+                fb.read(st.b[slot].data(), blk.p, p1, blk.j, j1);
+                guard.lock();
+                st.filled[slot] = true;
+                ++next;
+                st.cv.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(st.lock);
+            st.error = std::current_exception();
+            st.cv.notify_all();
+        }
+    });
+
+    std::exception_ptr error;
+    try {
+        size_t out = 0;
+        forn(step, steps.size()) {
+            const __m_block& blk = steps[step];
+            size_t slot = step % 2;
+            size_t rows = std::min(blk.i + mb, m) - blk.i;
+            size_t cols = std::min(blk.j + nb, n) - blk.j;
+            size_t depth = std::min(blk.p + kb, k) - blk.p;
+            {
+                std::unique_lock<std::mutex> guard(st.lock);
+                st.cv.wait(guard, [&]() {
+                    return st.error || (st.filled[slot] &&
+                        (blk.p != 0 || !st.pending[out]));
+                });
+                if (st.error) {
+                    break;
+                }
+            }
+
+            const double* a = st.a[slot].data();
+            const double* b = st.b[slot].data();
+            double* c = st.c[out].data();
+            bool accumulate = blk.p != 0;
+            ThreadPool::shared().parallelFor(0, rows, num_threads,
+                [=](size_t lefti, size_t righti) {
+                    kernel::gemmRows(a, depth, b, cols, c, cols,
+                        lefti, righti, cols, depth, accumulate);
+                });
+
+            std::lock_guard<std::mutex> guard(st.lock);
+            st.filled[slot] = false;
+            if (blk.p + kb >= k) {
+                st.written[out] = blk;
+                st.pending[out] = true;
+                out ^= 1;
+            }
+            st.cv.notify_all();
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+
+    {
+        std::unique_lock<std::mutex> guard(st.lock);
+        st.cv.wait(guard, [&]() {
+            return st.error || (!st.pending[0] && !st.pending[1]);
+        });
+        st.stop = true;
+        st.cv.notify_all();
+    }
+    io.join();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (st.error) {
+        std::rethrow_exception(st.error);
+    }
+}
+
+}  // namespace matrix
+
+#undef forn
@@ -0,0 +1,226 @@
+#include "Matrix.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+#define forf(i, n1, n2) for (size_t i = size_t(n1); i < size_t(n2); ++i)
+
+namespace matrix {
+
+static const int STRUCTURE_UNKNOWN = -1;
+
+// Operands with a band narrower than this are multiplied row by row with
+// axpys over the band; wider ones go through the blocked GEMM kernel on
+// blocks of this size, skipping the inner ranges the bands cannot reach.
+static const size_t STRUCTURE_BLOCK = 64;
+
+static bool isZero(double x) {
+    return std::fpclassify(x) == FP_ZERO;
+}
+
+// Columns [*first, *last) of row i that a (lower, upper) band reaches.
+static void bandRange(size_t i, size_t lower, size_t upper, size_t cols,
+        size_t* first, size_t* last) {
+    *first = std::min(i > lower ? i - lower : 0, cols);
+    *last = std::max(*first, std::min(cols, i + upper + 1));
+}
+
+void Matrix::forgetStructure_() {
+    if (structure_.load(std::memory_order_relaxed) != STRUCTURE_UNKNOWN) {
+        structure_.store(STRUCTURE_UNKNOWN, std::memory_order_relaxed);
+    }
+}
+
+void Matrix::copyStructure_(const Matrix& other) {
+    int structure = other.structure_.load(std::memory_order_acquire);
+    lower_.store(other.lower_.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    upper_.store(other.upper_.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    structure_.store(structure, std::memory_order_release);
+}
+
+void Matrix::setStructure(Structure structure, size_t lower, size_t upper) {
+    if (structure != Structure::General && rows_ != cols_) {
+        throw "Matrix: setStructure: unappropriate arguments";
+    }
+    switch (structure) {
+        case Structure::General: lower = rows_; upper = cols_; break;
+        case Structure::Identity:
+        case Structure::Diagonal: lower = upper = 0; break;
+        case Structure::UpperTriangular: lower = 0; upper = cols_; break;
+        case Structure::LowerTriangular: lower = rows_; upper = 0; break;
+        case Structure::Banded: break;
+    }
+    lower_.store(lower, std::memory_order_relaxed);
+    upper_.store(upper, std::memory_order_relaxed);
+    structure_.store(static_cast<int>(structure), std::memory_order_release);
+}
+
+// Widens the band row by row, scanning only the columns outside it, and
+// gives up on the first row that makes the band too wide to be worth it.
+// A dense matrix is recognized after a row or two.
+__m_structure Matrix::detectStructure_() const {
+    size_t n = rows_;
+    size_t lower = 0;
+    size_t upper = 0;
+    Structure res = Structure::General;
+    if (rows_ == cols_) {
+        size_t limit = std::max<size_t>(1, n / BAND_MAX_FRACTION);
+        const double* data = val_.get();
+        bool general = false;
+        for (size_t i = 0; i < n && !general; ++i) {
+            const double* row = data + i * n;
+            for (size_t j = 0; j + lower < i; ++j) {
+                if (!isZero(row[j])) {
+                    lower = i - j;
+                    break;
+                }
+            }
+            for (size_t j = n; j-- > i + upper + 1;) {
+                if (!isZero(row[j])) {
+                    upper = j - i;
+                    break;
+                }
+            }
+            general = lower > 0 && upper > 0 && lower + upper + 1 > limit;
+        }
+        if (general) {
+            res = Structure::General;
+        } else if (lower == 0 && upper == 0) {
+            res = Structure::Identity;
+            forn(i, n) {
+                if (!isZero(data[i * n + i] - 1.0)) {
+                    res = Structure::Diagonal;
+                    break;
+                }
+            }
+        } else if (lower == 0) {
+            res = Structure::UpperTriangular;
+        } else if (upper == 0) {
+            res = Structure::LowerTriangular;
+        } else {
+            res = Structure::Banded;
+        }
+    }
+    if (res == Structure::General) {
+        lower = rows_;
+        upper = cols_;
+    }
+    return __m_structure{res, lower, upper};
+}
+
+// A detected structure is not stored: a write through a pointer or view
+// taken earlier would leave it stale, and the scan is cheap next to the
+// product it routes.
+__m_structure Matrix::structureInfo_() const {
+    int structure = structure_.load(std::memory_order_acquire);
+    if (structure == STRUCTURE_UNKNOWN) {
+        return detectStructure_();
+    }
+    return __m_structure{static_cast<Structure>(structure),
+        lower_.load(std::memory_order_relaxed),
+        upper_.load(std::memory_order_relaxed)};
+}
+
+Structure Matrix::structure() const {
+    return structureInfo_().structure;
+}
+
+size_t Matrix::LowerBandwidth() const {
+    return structureInfo_().lower;
+}
+
+size_t Matrix::UpperBandwidth() const {
+    return structureInfo_().upper;
+}
+
+// Both kernels add the products for every element of C in ascending inner
+// index starting from zero, exactly like the dense kernel, and skip only
+// products with a zero factor. For finite operands those products are
+// zeros and the result is bit-identical to the dense one. With an infinite
+// or NaN operand it is not: a skipped 0 * Inf would have been NaN, and the
+// identity copy keeps a -0.0 that the dense sum would turn into +0.0.
+bool multiplyStructured(const Matrix& left, const Matrix& right,
+        Matrix& res) {
+    __m_structure li = left.structureInfo_();
+    __m_structure ri = right.structureInfo_();
+    Structure ls = li.structure;
+    Structure rs = ri.structure;
+    if (ls == Structure::General && rs == Structure::General) {
+        return false;
+    }
+    size_t m = left.Rows();
+    size_t k = left.Cols();
+    size_t n = right.Cols();
+    res.resize(m, n);
+    double* c = res.Data();
+
+    if (ls == Structure::Identity || rs == Structure::Identity) {
+        const double* src = ls == Structure::Identity ? right.Data() :
+            left.Data();
+        ThreadPool::shared().parallelFor(0, m, left.Threads(),
+            [src, c, n](size_t lefti, size_t righti) {
+                std::copy(src + lefti * n, src + righti * n, c + lefti * n);
+            });
+        return true;
+    }
+
+    const double* a = left.Data();
+    const double* b = right.Data();
+    size_t la = li.lower;
+    size_t ua = li.upper;
+    size_t lb = ri.lower;
+    size_t ub = ri.upper;
+    bool narrow = (ls != Structure::General && la + ua < STRUCTURE_BLOCK) ||
+        (rs != Structure::General && lb + ub < STRUCTURE_BLOCK);
+    size_t nb = rs == Structure::General ? std::max<size_t>(n, 1) :
+        STRUCTURE_BLOCK;
+
+    ThreadPool::shared().parallelFor(0, m, left.Threads(),
+        [=](size_t lefti, size_t righti) {
+            if (narrow) {
+                forf(i, lefti, righti) {
+                    double* ci = c + i * n;
+                    std::fill(ci, ci + n, 0.0);
+                    size_t p0, p1;
+                    bandRange(i, la, ua, k, &p0, &p1);
+                    forf(p, p0, p1) {
+                        size_t j0, j1;
+                        bandRange(p, lb, ub, n, &j0, &j1);
+                        kernel::axpy(a[i * k + p], b + p * n + j0, ci + j0,
+                            j1 - j0);
+                    }
+                }
+                return;
+            }
+            for (size_t i0 = lefti; i0 < righti; i0 += STRUCTURE_BLOCK) {
+                size_t i1 = std::min(righti, i0 + STRUCTURE_BLOCK);
+                size_t pa0 = std::min(i0 > la ? i0 - la : 0, k);
+                size_t pa1 = std::min(k, i1 + ua);
+                for (size_t j0 = 0; j0 < n; j0 += nb) {
+                    size_t j1 = std::min(n, j0 + nb);
+                    size_t p0 = std::max(pa0, j0 > ub ? j0 - ub : 0);
+                    size_t p1 = std::min(pa1, j1 + lb);
+                    if (p0 >= p1) {
+                        forf(i, i0, i1) {
+                            std::fill(c + i * n + j0, c + i * n + j1, 0.0);
+                        }
+                        continue;
+                    }
+                    kernel::gemmRows(a + p0, k, b + p0 * n + j0, n, c + j0,
+                        n, i0, i1, j1 - j0, p1 - p0);
+                }
+            }
+        });
+    return true;
+}
+
+}  // namespace matrix
+
+#undef forn
+#undef forf
@@ -0,0 +1,272 @@
+#include "ThreadPool.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "Numa.hpp"
+
+#define forn(i, n) for (size_t i = 0; i < size_t(n); ++i)
+
+namespace matrix {
+
+// One parallelFor call. Each chunk is run by whoever claims it first: its
+// worker, or the calling thread once it is done with chunk 0. The caller
+// then only waits for chunks already running, so it never has to pick up
+// unrelated tasks to make progress, and nothing else ends up nested on its
+// stack. Queued tasks may outlive the call, hence the shared ownership;
+// they touch the job only after a successful claim.
+struct __range_state {
+    std::mutex lock;
+    std::condition_variable cv;
+    size_t remaining;
+    size_t parts;
+    std::exception_ptr error;
+    std::unique_ptr<std::atomic<bool>[]> claimed;
+
+    explicit __range_state(size_t num_parts) : remaining(num_parts),
+        parts(num_parts), claimed(new std::atomic<bool>[num_parts]) {
+        forn(i, parts) {
+            claimed[i].store(false, std::memory_order_relaxed);
+        }
+    }
+
+    bool runChunk(const __range_job& job, size_t begin, size_t end,
+            size_t i, std::exception_ptr* first_error) {
+        if (claimed[i].exchange(true, std::memory_order_acq_rel)) {
+            return false;
+        }
+        size_t n = end - begin;
+        size_t lefti = begin + i * (n / parts);
+        size_t righti = i == parts - 1 ? end : begin + (i + 1) * (n / parts);
+        try {
+            job(lefti, righti);
+        } catch (...) {
+            if (!*first_error) {
+                *first_error = std::current_exception();
+            }
+        }
+        return true;
+    }
+};
+
+static const size_t NO_WORKER = SIZE_MAX;
+
+// Which worker of which pool the current thread is, if any.
+struct __worker_self {
+    const ThreadPool* pool;
+    size_t index;
+};
+
+static thread_local __worker_self self_ = {nullptr, NO_WORKER};
+
+static size_t selfIn(const ThreadPool* pool) {
+    return self_.pool == pool ? self_.index : NO_WORKER;
+}
+
+ThreadPool::ThreadPool(size_t num_threads, bool pin) :
+    cpus_(num_threads, -1), local_(num_threads), stop_(false),
+    pinned_(false) {
+    std::vector<int> cpus;
+    if (pin) {
+        cpus = numa::placementCpus();
+        pinned_ = !cpus.empty();
+    }
+    forn(i, num_threads) {
+        workers_.push_back(std::thread(&ThreadPool::workerLoop_, this, i));
+        if (pinned_ && numa::pinThread(workers_[i], cpus[i % cpus.size()])) {
+            cpus_[i] = cpus[i % cpus.size()];
+        }
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    forn(i, workers_.size()) {
+        workers_[i].join();
+    }
+}
+
+size_t ThreadPool::Size() const { return workers_.size(); }
+bool ThreadPool::Pinned() const { return pinned_; }
+
+int ThreadPool::WorkerCpu(size_t worker) const {
+    return worker < cpus_.size() ? cpus_[worker] : -1;
+}
+
+int ThreadPool::WorkerNode(size_t worker) const {
+    int cpu = WorkerCpu(worker);
+    return cpu < 0 ? -1 : numa::nodeOfCpu(cpu);
+}
+
+void ThreadPool::submit(__task task) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::submitTo(size_t worker, __task task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        local_[worker % local_.size()].push_back(std::move(task));
+    }
+    cv_.notify_all();
+}
+
+// Own queue first, then the common one, then (if allowed) other workers'.
+// Called with lock_ held.
+bool ThreadPool::popTask_(size_t self, bool steal, __task* task) {
+    std::deque<__task>* from = nullptr;
+    if (self != NO_WORKER && !local_[self].empty()) {
+        from = &local_[self];
+    } else if (!tasks_.empty()) {
+        from = &tasks_;
+    } else if (steal) {
+        size_t start = self == NO_WORKER ? 0 : self + 1;
+        forn(i, local_.size()) {
+            std::deque<__task>& other = local_[(start + i) % local_.size()];
+            if (!other.empty()) {
+                from = &other;
+                break;
+            }
+        }
+    }
+    if (from == nullptr) {
+        return false;
+    }
+    *task = std::move(from->front());
+    from->pop_front();
+    return true;
+}
+
+bool ThreadPool::runPending() {
+    __task task;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (!popTask_(selfIn(this), true, &task)) {
+            return false;
+        }
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::helpUntil(const std::function<bool(void)>& done) {
+    size_t self = selfIn(this);
+    for (;;) {
+        __task task;
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            cv_.wait(guard, [this, self, &done, &task]() {
+                return done() || popTask_(self, true, &task);
+            });
+            if (!task) {
+                // The wakeup may have been a submit meant for a worker.
+                guard.unlock();
+                cv_.notify_one();
+                return;
+            }
+        }
+        task();
+    }
+}
+
+void ThreadPool::wake() {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+    }
+    cv_.notify_all();
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t parts,
+        const __range_job& job) {
+    size_t n = end - begin;
+    if (parts > n) {
+        parts = n;
+    }
+    if (parts <= 1 || workers_.empty()) {
+        if (n != 0) {
+            job(begin, end);
+        }
+        return;
+    }
+
+    std::shared_ptr<__range_state> state =
+        std::make_shared<__range_state>(parts);
+    const __range_job* pjob = &job;
+    for (size_t i = 1; i < parts; ++i) {
+        submitTo(i - 1, [state, pjob, begin, end, i]() {
+            std::exception_ptr error;
+            if (!state->runChunk(*pjob, begin, end, i, &error)) {
+                return;
+            }
+            std::lock_guard<std::mutex> guard(state->lock);
+            if (error && !state->error) {
+                state->error = error;
+            }
+            if (--state->remaining == 0) {
+                state->cv.notify_all();
+            }
+        });
+    }
+
+    // Chunk 0, then whatever no worker has started yet.
+    std::exception_ptr error;
+    size_t done = 0;
+    forn(i, parts) {
+        if (state->runChunk(job, begin, end, i, &error)) {
+            ++done;
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> guard(state->lock);
+        state->remaining -= done;
+        state->cv.wait(guard, [&state]() { return state->remaining == 0; });
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool(std::thread::hardware_concurrency() > 1 ?
+        std::thread::hardware_concurrency() : 1, numa::nodeCount() > 1);
+    return pool;
+}
+
+void ThreadPool::workerLoop_(size_t self) {
+    self_ = {this, self};
+    bool steal = !pinned_;
+    for (;;) {
+        __task task;
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            cv_.wait(guard, [this, self, steal, &task]() {
+                return popTask_(self, steal, &task) || stop_;
+            });
+            if (!task) {
+                return;
+            }
+        }
+        task();
+    }
+}
+
+}  // namespace matrix
+
+#undef forn
@@ -0,0 +1,109 @@
+#include "Matrix.hpp"
+
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+
+namespace matrix {
+
+Transposed::Transposed(const Matrix& base) : base_(base) {}
+
+const Matrix& Transposed::Base() const { return base_; }
+size_t Transposed::Rows() const { return base_.Cols(); }
+size_t Transposed::Cols() const { return base_.Rows(); }
+
+Transposed transposed(const Matrix& m) {
+    return Transposed(m);
+}
+
+Matrix Matrix::computeTransposed() const {
+    Matrix res(cols_, rows_, nThreads_);
+    const double* src = Data();
+    double* dst = res.Data();
+    size_t rows = rows_;
+    size_t cols = cols_;
+    ThreadPool::shared().parallelFor(0, cols_, nThreads_,
+        [src, dst, rows, cols](size_t lefti, size_t righti) {
+            kernel::transposeBlock(src, cols, dst, rows,
+                0, rows, lefti, righti);
+        });
+    // A known structure carries over with the two bands swapped.
+    if (structure_.load(std::memory_order_acquire) >= 0) {
+        __m_structure info = structureInfo_();
+        Structure s = info.structure;
+        if (s == Structure::UpperTriangular) {
+            s = Structure::LowerTriangular;
+        } else if (s == Structure::LowerTriangular) {
+            s = Structure::UpperTriangular;
+        }
+        res.setStructure(s, info.upper, info.lower);
+    }
+    return res;
+}
+
+void Matrix::transposeInPlace() {
+    if (rows_ != cols_) {
+        throw "Matrix: transposeInPlace: unappropriate arguments";
+    }
+    // Tile row t costs (n_tiles - t) swaps, so row t is paired with row
+    // n_tiles - 1 - t to give every chunk the same amount of work.
+    size_t tiles = (rows_ + kernel::TRANSPOSE_TILE - 1) /
+        kernel::TRANSPOSE_TILE;
+    double* a = Data();
+    size_t n = rows_;
+    ThreadPool::shared().parallelFor(0, (tiles + 1) / 2, nThreads_,
+        [a, n, tiles](size_t lefti, size_t righti) {
+            for (size_t t = lefti; t < righti; ++t) {
+                kernel::transposeTileRow(a, n, n, t);
+                if (tiles - 1 - t != t) {
+                    kernel::transposeTileRow(a, n, n, tiles - 1 - t);
+                }
+            }
+        });
+}
+
+void multiply(const Matrix& left, const Transposed& right, Matrix& res) {
+    const Matrix& b = right.Base();
+    if (left.Cols() != right.Rows()) {
+        throw "Matrix: multiply: unappropriate arguments";
+    }
+    if (&res == &left || &res == &b) {
+        throw "Matrix: multiply: result aliases an argument";
+    }
+    res.resize(left.Rows(), right.Cols());
+    ThreadPool::shared().parallelFor(0, left.Rows(), left.Threads(),
+        [&left, &b, &res](size_t lefti, size_t righti) {
+            kernel::gemmNTRows(left.Data(), left.Cols(), b.Data(), b.Cols(),
+                res.Data(), res.Cols(), lefti, righti, b.Rows(), b.Cols());
+        });
+}
+
+void multiply(const Transposed& left, const Matrix& right, Matrix& res) {
+    const Matrix& a = left.Base();
+    if (left.Cols() != right.Rows()) {
+        throw "Matrix: multiply: unappropriate arguments";
+    }
+    if (&res == &a || &res == &right) {
+        throw "Matrix: multiply: result aliases an argument";
+    }
+    res.resize(left.Rows(), right.Cols());
+    ThreadPool::shared().parallelFor(0, left.Rows(), a.Threads(),
+        [&a, &right, &res](size_t lefti, size_t righti) {
+            kernel::gemmTNRows(a.Data(), a.Cols(), right.Data(), right.Cols(),
+                res.Data(), res.Cols(), lefti, righti, right.Cols(),
+                a.Rows());
+        });
+}
+
+Matrix operator*(const Matrix& left, const Transposed& right) {
+    Matrix res(left.Rows(), right.Cols(), left.Threads());
+    multiply(left, right, res);
+    return res;
+}
+
+Matrix operator*(const Transposed& left, const Matrix& right) {
+    Matrix res(left.Rows(), right.Cols(), left.Base().Threads());
+    multiply(left, right, res);
+    return res;
+}
+
+}  // namespace matrix
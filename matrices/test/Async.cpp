@@ -0,0 +1,108 @@
+#include "Test.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Async.hpp"
+#include "Matrix.hpp"
+
+TEST(futureThenChains) {
+    matrix::Future<int> f = matrix::runAsync([]() { return 20; });
+    matrix::Future<int> g = f.then([](int x) { return x + 1; })
+        .then([](int x) { return 2 * x; });
+    matrix::Future<std::string> h = g.then([](int x) {
+        return std::to_string(x);
+    });
+    CHECK(h.get() == "42");
+    CHECK(g.get() == 42 && g.get() == 42);
+    CHECK(f.ready());
+
+    // Continuations attached after completion still run.
+    CHECK(f.then([](int x) { return x - 20; }).get() == 0);
+
+    matrix::Future<int> ready(7);
+    CHECK(ready.valid() && ready.ready() && ready.get() == 7);
+    CHECK(!matrix::Future<int>().valid());
+    CHECK_THROWS(matrix::Future<int>().wait());
+}
+
+TEST(futureErrorsPropagate) {
+    matrix::Future<int> f = matrix::runAsync([]() -> int {
+        throw std::runtime_error("boom");
+    });
+    std::atomic<bool> ran(false);
+    matrix::Future<int> g = f.then([&ran](int x) {
+        ran = true;
+        return x;
+    });
+    bool caught = false;
+    try {
+        g.get();
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    CHECK(caught && !ran);
+
+    matrix::Future<int> both = matrix::whenBoth(matrix::Future<int>(1), f,
+        [](int x, int y) { return x + y; });
+    CHECK_THROWS(matrix::whenBoth(matrix::Future<int>(1),
+        matrix::runAsync([]() -> int { throw "inner"; }),
+        [](int x, int y) { return x + y; }).get());
+    caught = false;
+    try {
+        both.get();
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    CHECK(caught);
+}
+
+TEST(promiseCompletesOnce) {
+    matrix::Promise<int> p;
+    matrix::Future<int> f = p.future();
+    matrix::Future<int> g = f.then([](int x) { return x * 3; });
+    CHECK(!f.ready());
+    p.setValue(5);
+    CHECK(g.get() == 15);
+    CHECK_THROWS(p.setValue(6));
+    CHECK_THROWS(p.setError(std::make_exception_ptr(1)));
+}
+
+TEST(asyncMatrixPipeline) {
+    matrix::Matrix a = test::random(40, 30, 101, 2);
+    matrix::Matrix b = test::random(30, 50, 102, 2);
+    matrix::Matrix c = test::random(40, 50, 103, 2);
+    matrix::Future<matrix::Matrix> ab = matrix::multiplyAsync(a, b);
+    matrix::Future<matrix::Matrix> sum = matrix::addAsync(ab,
+        matrix::scaleAsync(2.0, c));
+    matrix::Future<matrix::Matrix> res = matrix::transposeAsync(
+        matrix::subtractAsync(matrix::hadamardAsync(sum, sum), c));
+    matrix::Matrix s = test::reference(a, b);
+    for (size_t i = 0; i < s.Rows(); ++i) {
+        for (size_t j = 0; j < s.Cols(); ++j) {
+            s[i][j] += 2.0 * c[i][j];
+            s[i][j] = s[i][j] * s[i][j] - c[i][j];
+        }
+    }
+    CHECK(test::near(res.get(), s.computeTransposed()));
+    CHECK(test::near(matrix::applyAsync(a, [](double x) {
+        return x + 1.0;
+    }).get() - a, matrix::apply(a, [](double) { return 1.0; })));
+    CHECK_THROWS(matrix::multiplyAsync(a, a).get());
+}
+
+TEST(futuresWaitedOnInsidePoolTasks) {
+    // Many tasks that each wait on a future of their own must not starve
+    // the pool.
+    std::vector<matrix::Future<int>> outer;
+    for (int i = 0; i < 64; ++i) {
+        outer.push_back(matrix::runAsync([i]() {
+            return matrix::runAsync([i]() { return i; }).get() + 1;
+        }));
+    }
+    for (int i = 0; i < 64; ++i) {
+        CHECK(outer[static_cast<size_t>(i)].get() == i + 1);
+    }
+}
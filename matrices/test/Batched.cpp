@@ -0,0 +1,61 @@
+#include "Test.hpp"
+
+#include <vector>
+
+#include "Batched.hpp"
+#include "Matrix.hpp"
+
+// Runs a batch of m x k by k x n products, the operands packed with some
+// padding between them, and checks every one against the reference.
+static bool batchMatches(size_t m, size_t n, size_t k, size_t batch,
+        size_t num_threads) {
+    size_t stride_a = m * k + 3;
+    size_t stride_b = k * n + 5;
+    size_t stride_c = m * n + 1;
+    matrix::Matrix as = test::random(batch, stride_a, 21);
+    matrix::Matrix bs = test::random(batch, stride_b, 22);
+    std::vector<double> cs(batch * stride_c, -7.0);
+    matrix::gemmBatched(m, n, k, as.Data(), stride_a, bs.Data(), stride_b,
+        cs.data(), stride_c, batch, num_threads);
+
+    for (size_t t = 0; t < batch; ++t) {
+        matrix::Matrix a(m, k);
+        matrix::Matrix b(k, n);
+        std::copy(as[t], as[t] + m * k, a.Data());
+        std::copy(bs[t], bs[t] + k * n, b.Data());
+        matrix::Matrix c = test::reference(a, b);
+        for (size_t i = 0; i < m * n; ++i) {
+            if (!test::near(cs[t * stride_c + i], c.Data()[i])) {
+                return false;
+            }
+        }
+        if (!test::same(cs[t * stride_c + m * n], -7.0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(gemmBatchedFixedSizes) {
+    for (size_t s : {4, 8, 16, 32, 64}) {
+        CHECK(batchMatches(s, s, s, 9, 4));
+    }
+}
+
+TEST(gemmBatchedGeneralShapes) {
+    CHECK(batchMatches(3, 5, 7, 40, 4));
+    CHECK(batchMatches(1, 1, 1, 3, 1));
+    CHECK(batchMatches(5, 5, 5, 1000, 3));
+    CHECK(batchMatches(8, 8, 4, 10, 2));
+}
+
+TEST(gemmBatchedFloat) {
+    std::vector<float> a(2 * 16, 1.0f);
+    std::vector<float> b(2 * 16, 2.0f);
+    std::vector<float> c(2 * 16, 0.0f);
+    matrix::gemmBatched<float>(4, 4, 4, a.data(), 16, b.data(), 16,
+        c.data(), 16, 2);
+    for (float x : c) {
+        CHECK(test::same(x, 8.0));
+    }
+}
@@ -0,0 +1,55 @@
+#include "Test.hpp"
+
+#include <vector>
+
+#include "Matrix.hpp"
+
+static matrix::Matrix leftToRight(const std::vector<matrix::Matrix>& v) {
+    matrix::Matrix res(v[0]);
+    for (size_t i = 1; i < v.size(); ++i) {
+        res = test::reference(res, v[i]);
+    }
+    return res;
+}
+
+TEST(chainMatchesLeftToRight) {
+    // Shapes where the best order is far from left to right, with 1 x n
+    // and n x 1 factors in between.
+    std::vector<size_t> dims = {40, 3, 57, 1, 29, 61, 2, 33};
+    std::vector<matrix::Matrix> v;
+    for (size_t i = 0; i + 1 < dims.size(); ++i) {
+        v.push_back(test::random(dims[i], dims[i + 1],
+            static_cast<unsigned>(90 + i), 3));
+    }
+    matrix::Matrix res = matrix::multiplyChain(
+        matrix::__matrix_chain(v.begin(), v.end()));
+    CHECK(test::near(res, leftToRight(v), 1e-12));
+
+    for (size_t n = 1; n < v.size(); ++n) {
+        std::vector<matrix::Matrix> prefix(v.begin(),
+            v.begin() + static_cast<long>(n));
+        CHECK(test::near(matrix::multiplyChain(
+            matrix::__matrix_chain(prefix.begin(), prefix.end())),
+            leftToRight(prefix), 1e-12));
+    }
+}
+
+TEST(chainTakesTemporaries) {
+    matrix::Matrix a = test::random(5, 6, 95);
+    matrix::Matrix b = test::random(6, 7, 96);
+    matrix::Matrix c = test::random(7, 4, 97);
+    matrix::Matrix expected = test::reference(test::reference(a, b), c);
+    CHECK(test::near(matrix::multiplyChain(a, b, c), expected, 1e-12));
+    CHECK(test::near(matrix::multiplyChain(a, matrix::Matrix(b), c),
+        expected, 1e-12));
+    CHECK(test::near(matrix::multiplyChain(test::random(5, 6, 95),
+        matrix::Matrix::Identity(6), b * c), expected, 1e-12));
+    CHECK(test::near(matrix::multiplyChain(a), a, 0));
+}
+
+TEST(chainRejectsBadShapes) {
+    matrix::Matrix a(3, 4);
+    matrix::Matrix b(5, 2);
+    CHECK_THROWS(matrix::multiplyChain(a, b));
+    CHECK_THROWS(matrix::multiplyChain(matrix::__matrix_chain()));
+}
@@ -0,0 +1,113 @@
+#include "Test.hpp"
+
+#include <cmath>
+#include <limits>
+
+#include "Elementwise.hpp"
+#include "Matrix.hpp"
+
+TEST(elementwiseArithmetic) {
+    matrix::Matrix a = test::random(37, 1301, 51, 4);
+    matrix::Matrix b = test::random(37, 1301, 52, 4);
+    matrix::Matrix sum = a + b;
+    matrix::Matrix diff = a - b;
+    matrix::Matrix prod = matrix::hadamard(a, b);
+    matrix::Matrix scaled = 2.5 * a;
+    matrix::Matrix axpy(a);
+    matrix::axpy(-3.0, b, axpy);
+    for (size_t i = 0; i < a.Rows(); ++i) {
+        for (size_t j = 0; j < a.Cols(); ++j) {
+            CHECK(test::same(sum[i][j], a[i][j] + b[i][j]));
+            CHECK(test::same(diff[i][j], a[i][j] - b[i][j]));
+            CHECK(test::same(prod[i][j], a[i][j] * b[i][j]));
+            CHECK(test::same(scaled[i][j], 2.5 * a[i][j]));
+            CHECK(test::same(axpy[i][j], a[i][j] + -3.0 * b[i][j]));
+        }
+    }
+    matrix::Matrix c(a);
+    c += b;
+    c -= b;
+    c *= 1.0;
+    CHECK(test::near(c, a));
+    CHECK(test::near(matrix::apply(a, [](double x) { return -x; }),
+        -1.0 * a, 0));
+}
+
+TEST(elementwiseRejectsMismatchedShapes) {
+    matrix::Matrix a(3, 4);
+    matrix::Matrix b(4, 3);
+    CHECK_THROWS(a + b);
+    CHECK_THROWS(a - b);
+    CHECK_THROWS(a += b);
+    CHECK_THROWS(matrix::hadamard(a, b));
+    CHECK_THROWS(matrix::axpy(1.0, b, a));
+}
+
+TEST(reductionsMatchPlainLoops) {
+    matrix::Matrix a = test::random(203, 331, 53, 4);
+    matrix::Vector rows = matrix::rowSums(a);
+    matrix::Vector cols = matrix::colSums(a);
+    matrix::Vector rowNorms = matrix::rowNorms(a);
+    matrix::Vector colNorms = matrix::colNorms(a);
+    CHECK(rows.size() == 203 && cols.size() == 331);
+    double total = 0.0;
+    double squares = 0.0;
+    for (size_t i = 0; i < a.Rows(); ++i) {
+        double r = 0.0;
+        double r2 = 0.0;
+        for (size_t j = 0; j < a.Cols(); ++j) {
+            r += a[i][j];
+            r2 += a[i][j] * a[i][j];
+        }
+        CHECK(test::near(rows[i], r));
+        CHECK(test::near(rowNorms[i], std::sqrt(r2)));
+        total += r;
+        squares += r2;
+    }
+    for (size_t j = 0; j < a.Cols(); ++j) {
+        double c = 0.0;
+        double c2 = 0.0;
+        for (size_t i = 0; i < a.Rows(); ++i) {
+            c += a[i][j];
+            c2 += a[i][j] * a[i][j];
+        }
+        CHECK(test::near(cols[j], c));
+        CHECK(test::near(colNorms[j], std::sqrt(c2)));
+    }
+    CHECK(test::near(matrix::sum(a), total));
+    CHECK(test::near(matrix::norm(a), std::sqrt(squares)));
+}
+
+TEST(reductionsIgnoreThreadCount) {
+    matrix::Matrix a = test::random(301, 517, 54, 1);
+    double sum = matrix::sum(a);
+    double norm = matrix::norm(a);
+    matrix::Vector cols = matrix::colSums(a);
+    matrix::Vector rows = matrix::rowSums(a);
+    for (size_t threads : {2, 3, 8}) {
+        a.setThreads(threads);
+        CHECK(test::same(matrix::sum(a), sum));
+        CHECK(test::same(matrix::norm(a), norm));
+        matrix::Vector c = matrix::colSums(a);
+        matrix::Vector r = matrix::rowSums(a);
+        for (size_t j = 0; j < cols.size(); ++j) {
+            CHECK(test::same(c[j], cols[j]));
+        }
+        for (size_t i = 0; i < rows.size(); ++i) {
+            CHECK(test::same(r[i], rows[i]));
+        }
+    }
+}
+
+TEST(maxAbsPropagatesNaN) {
+    CHECK(test::same(matrix::maxAbs(matrix::Matrix(0, 3)), 0.0));
+    matrix::Matrix a = test::random(300, 301, 55, 4);
+    a[123][45] = -7.0;
+    CHECK(test::same(matrix::maxAbs(a), 7.0));
+    a[299][300] = -std::numeric_limits<double>::infinity();
+    CHECK(std::isinf(matrix::maxAbs(a)));
+    a[0][0] = std::numeric_limits<double>::quiet_NaN();
+    CHECK(std::isnan(matrix::maxAbs(a)));
+    a.setThreads(1);
+    CHECK(std::isnan(matrix::maxAbs(a)));
+}
@@ -0,0 +1,100 @@
+#include "Test.hpp"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "FixedMatrix.hpp"
+#include "Matrix.hpp"
+#include "MatrixIO.hpp"
+
+typedef matrix::FixedMatrix<2, 3> M23;
+typedef matrix::FixedMatrix<3, 2> M32;
+typedef matrix::FixedMatrix<2, 2> M22;
+
+static_assert(M23{1, 2, 3, 4, 5, 6} * M32{1, 0, 0, 1, 1, 1} ==
+    M22{4, 5, 10, 11}, "FixedMatrix: constexpr product");
+static_assert(M22::Identity() * M22{1, 2, 3, 4} == M22{1, 2, 3, 4},
+    "FixedMatrix: constexpr identity");
+
+TEST(fixedMatchesDynamicProduct) {
+    matrix::Matrix a = test::random(3, 5, 61);
+    matrix::Matrix b = test::random(5, 4, 62);
+    matrix::FixedMatrix<3, 5> fa(a);
+    matrix::FixedMatrix<5, 4> fb(b);
+    CHECK(test::near((fa * fb).toMatrix(), test::reference(a, b)));
+    CHECK(test::near(fa.computeTransposed().toMatrix(),
+        a.computeTransposed(), 0));
+    CHECK_THROWS(matrix::FixedMatrix<4, 5> big(a));
+}
+
+TEST(fixedArithmetic) {
+    M23 a{1, 2, 3, 4, 5, 6};
+    M23 b{1, 1, 1};
+    CHECK(a + b == (M23{2, 3, 4, 4, 5, 6}));
+    CHECK(a - a == M23());
+    CHECK(2 * a == a + a);
+    CHECK(a * 3 == 3.0 * a);
+    matrix::FixedMatrix<2, 2, int> n{1, 2, 3, 4};
+    CHECK((2 * n)[1][1] == 8);
+}
+
+TEST(fixedEqualityIsElementwise) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    M22 a{1, nan, 3, 4};
+    CHECK(a != a);
+    CHECK(!(a == M22{1, 2, 3, 4}));
+    CHECK(!(M22{1, 2, 3, 4} == a));
+    CHECK(M22{0.0, 1, 1, 1} == (M22{-0.0, 1, 1, 1}));
+    CHECK(M22{1, 2, 3, 4} != (M22{1, 2, 3, 5}));
+}
+
+TEST(fixedViews) {
+    matrix::Matrix m = test::random(6, 7, 63);
+    auto v = matrix::view<2, 3>(m, 3, 4);
+    M23 block = v.load();
+    CHECK(test::same(block[1][2], m[4][6]));
+    v = 2.0 * block;
+    CHECK(test::same(m[4][6], 2.0 * block[1][2]));
+
+    // A float copy of a double block, written back converted.
+    matrix::FixedMatrix<2, 3, float> f = v.load<float>();
+    v = f;
+    CHECK(test::same(m[4][6], static_cast<double>(f[1][2])));
+
+    const matrix::Matrix& cm = m;
+    CHECK(matrix::view<2, 3>(cm, 3, 4).load() == v.load());
+    CHECK_THROWS(matrix::view<2, 3>(m, 5, 0));
+    CHECK_THROWS(matrix::view<2, 3>(cm, 0, 5));
+}
+
+TEST(fixedViewWritesReachProducts) {
+    // The view is taken before the structure is looked at.
+    matrix::Matrix m = matrix::Matrix::Identity(4);
+    matrix::Matrix b = test::random(4, 4, 65);
+    auto v = matrix::view<2, 2>(m);
+    CHECK(m.structure() == matrix::Structure::Identity);
+    CHECK(test::near(m * b, b, 0));
+    v = matrix::FixedMatrix<2, 2>{5, 5, 5, 5};
+    CHECK(test::same(m[0][1], 5.0));
+    CHECK(m.structure() == matrix::Structure::General);
+    CHECK(test::near(m * b, test::reference(m, b)));
+
+    // Writing through operator[] drops a tag set by hand as well.
+    matrix::Matrix d = matrix::Matrix::Identity(4);
+    auto w = matrix::view<2, 2>(d, 2, 2);
+    d.setStructure(matrix::Structure::Diagonal);
+    w[0][1] = 3.0;
+    CHECK(d.structure() == matrix::Structure::UpperTriangular);
+    CHECK(test::near(d * b, test::reference(d, b)));
+}
+
+TEST(fixedViewOfReadOnlyMatrix) {
+    test::TempFile file("fixed");
+    matrix::Matrix m = test::random(4, 4, 64);
+    matrix::writeBinary(m, file.path());
+    matrix::Matrix mapped = matrix::mapBinary(file.path());
+    M22 block = matrix::view<2, 2>(std::as_const(mapped), 1, 1).load();
+    CHECK(block == (matrix::FixedMatrix<2, 2>(m, 1, 1)));
+    CHECK_THROWS(matrix::view<2, 2>(mapped, 1, 1));
+}
@@ -0,0 +1,80 @@
+#include "Test.hpp"
+
+#include "Matrix.hpp"
+
+static matrix::Matrix column(const matrix::Vector& x) {
+    matrix::Matrix res(x.size(), 1);
+    for (size_t i = 0; i < x.size(); ++i) {
+        res[i][0] = x[i];
+    }
+    return res;
+}
+
+static matrix::Vector row(const matrix::Matrix& m, size_t i) {
+    return matrix::Vector(m[i], m[i] + m.Cols());
+}
+
+TEST(gemvMatchesReference) {
+    for (size_t threads : {1, 4}) {
+        matrix::Matrix a = test::random(301, 173, 3, threads);
+        matrix::Vector x = row(test::random(1, 173, 4), 0);
+        matrix::Vector y = a * x;
+        matrix::Matrix expected = test::reference(a, column(x));
+        CHECK(y.size() == 301);
+        for (size_t i = 0; i < y.size(); ++i) {
+            CHECK(test::near(y[i], expected[i][0]));
+        }
+    }
+}
+
+TEST(gemvTransposedMatchesReference) {
+    matrix::Matrix a = test::random(211, 67, 5, 3);
+    matrix::Vector x = row(test::random(1, 211, 6), 0);
+    matrix::Vector y = matrix::multiplyTransposed(a, x);
+    matrix::Matrix expected = test::reference(a.computeTransposed(),
+        column(x));
+    CHECK(y.size() == 67);
+    for (size_t i = 0; i < y.size(); ++i) {
+        CHECK(test::near(y[i], expected[i][0]));
+    }
+}
+
+TEST(gemvTransposedIntoUnalignedStorage) {
+    matrix::Matrix a = test::random(300, 150, 9, 4);
+    matrix::Vector x = row(test::random(1, 300, 10), 0);
+    matrix::Vector expected = matrix::multiplyTransposed(a, x);
+    for (size_t offset = 0; offset < 8; ++offset) {
+        matrix::Vector storage(150 + 8, -1);
+        matrix::gemvTransposed(a, x.data(), storage.data() + offset);
+        for (size_t i = 0; i < storage.size(); ++i) {
+            bool inside = i >= offset && i < offset + 150;
+            CHECK(inside ? test::near(storage[i], expected[i - offset]) :
+                test::same(storage[i], -1.0));
+        }
+    }
+}
+
+TEST(gemvBatchedMatchesSingleVectors) {
+    matrix::Matrix a = test::random(150, 90, 7, 4);
+    matrix::Matrix xs = test::random(11, 90, 8);
+    matrix::Matrix ys(0);
+    matrix::gemvBatched(a, xs, ys);
+    CHECK(ys.Rows() == 11 && ys.Cols() == 150);
+    for (size_t v = 0; v < xs.Rows(); ++v) {
+        matrix::Vector y = a * row(xs, v);
+        for (size_t i = 0; i < y.size(); ++i) {
+            CHECK(test::same(ys[v][i], y[i]));
+        }
+    }
+}
+
+TEST(gemvRejectsBadShapes) {
+    matrix::Matrix a(4, 3);
+    CHECK_THROWS(a * matrix::Vector(4));
+    CHECK_THROWS(matrix::multiplyTransposed(a, matrix::Vector(3)));
+    matrix::Matrix xs(2, 4);
+    matrix::Matrix ys(0);
+    CHECK_THROWS(matrix::gemvBatched(a, xs, ys));
+    matrix::Matrix square(3, 3);
+    CHECK_THROWS(matrix::gemvBatched(square, square, square));
+}
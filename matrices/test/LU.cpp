@@ -0,0 +1,93 @@
+#include "Test.hpp"
+
+#include <cmath>
+
+#include "Elementwise.hpp"
+#include "LU.hpp"
+#include "Matrix.hpp"
+
+// Random entries plus n on the diagonal keep the system well conditioned.
+static matrix::Matrix wellConditioned(size_t n, unsigned seed,
+        size_t num_threads) {
+    matrix::Matrix a = test::random(n, n, seed, num_threads);
+    for (size_t i = 0; i < n; ++i) {
+        a[i][i] += static_cast<double>(n);
+    }
+    return a;
+}
+
+TEST(luSolvesAcrossBlockSizes) {
+    for (size_t n : {1, 9, 133}) {
+        matrix::Matrix a = wellConditioned(n, 71, 4);
+        matrix::Matrix b = test::random(n, 13, 72);
+        for (size_t block : {1, 7, 64, 200}) {
+            matrix::LU lu(a, block);
+            CHECK(!lu.isSingular());
+            matrix::Matrix x = lu.solve(b);
+            CHECK(test::near(test::reference(a, x), b, 1e-10));
+        }
+    }
+}
+
+TEST(luFactorsReproduceTheMatrix) {
+    size_t n = 70;
+    matrix::Matrix a = test::random(n, n, 73, 3);
+    matrix::LU lu(a, 16);
+    matrix::Matrix l = matrix::Matrix::Identity(n);
+    matrix::Matrix u(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            (i > j ? l[i][j] : u[i][j]) = lu.Factors()[i][j];
+        }
+    }
+    matrix::Matrix pa(a);
+    for (size_t i = 0; i < n; ++i) {
+        std::swap_ranges(pa[i], pa[i] + n, pa[lu.Pivots()[i]]);
+    }
+    CHECK(test::near(test::reference(l, u), pa, 1e-12));
+}
+
+TEST(luDeterminantAndInverse) {
+    matrix::Matrix a(matrix::__matrix{{0, 2, 1}, {1, 1, 0}, {3, 0, 1}});
+    matrix::LU lu(a);
+    CHECK(test::near(lu.determinant(), -5.0));
+    CHECK(test::near(test::reference(a, lu.inverse()),
+        matrix::Matrix::Identity(3)));
+
+    matrix::Matrix s(matrix::__matrix{{1, 2}, {2, 4}});
+    matrix::LU singular(s);
+    CHECK(singular.isSingular());
+    CHECK(test::same(singular.determinant(), 0.0));
+    CHECK_THROWS(singular.solve(matrix::Vector{1, 1}));
+}
+
+TEST(solveRoutesOnStructure) {
+    size_t n = 50;
+    matrix::Matrix b = test::random(n, 3, 74);
+    matrix::Matrix lower = wellConditioned(n, 75, 2);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i + 1; j < n; ++j) {
+            lower[i][j] = 0.0;
+        }
+    }
+    CHECK(lower.structure() == matrix::Structure::LowerTriangular);
+    CHECK(test::near(test::reference(lower, matrix::solve(lower, b)), b,
+        1e-10));
+    matrix::Matrix upper = lower.computeTransposed();
+    CHECK(test::near(test::reference(upper, matrix::solve(upper, b)), b,
+        1e-10));
+    CHECK(test::near(matrix::solve(matrix::Matrix::Identity(n), b), b, 0));
+
+    matrix::Vector x = matrix::solve(lower, matrix::Vector(n, 1.0));
+    CHECK(x.size() == n);
+    lower[3][3] = 0.0;
+    CHECK_THROWS(matrix::solve(lower, b));
+}
+
+TEST(luRejectsBadShapes) {
+    CHECK_THROWS(matrix::LU(matrix::Matrix(3, 4)));
+    matrix::LU lu(matrix::Matrix::Identity(3));
+    CHECK_THROWS(lu.solve(matrix::Vector(4)));
+    CHECK_THROWS(lu.solve(matrix::Matrix(2, 2)));
+    CHECK_THROWS(matrix::solve(matrix::Matrix(3, 4), matrix::Matrix(3, 1)));
+}
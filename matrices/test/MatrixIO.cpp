@@ -0,0 +1,165 @@
+#include "Test.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include "Matrix.hpp"
+#include "MatrixIO.hpp"
+
+static void writeFile(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+}
+
+// Overwrites one header field of an existing binary file.
+static void patch(const std::string& path, size_t offset, uint64_t value) {
+    std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(static_cast<std::streamoff>(offset));
+    f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+TEST(binaryRoundTrip) {
+    test::TempFile file("binary");
+    for (size_t rows : {0, 1, 13}) {
+        for (size_t cols : {0, 1, 29}) {
+            matrix::Matrix m = test::random(rows, cols, 31);
+            matrix::writeBinary(m, file.path());
+            matrix::__m_file_header header = matrix::readHeader(file.path());
+            CHECK(header.rows == rows && header.cols == cols);
+            CHECK(header.dataOffset % header.alignment == 0);
+            CHECK(test::near(matrix::readBinary(file.path(), 2), m, 0));
+            CHECK(test::near(matrix::mapBinary(file.path()), m, 0));
+        }
+    }
+}
+
+TEST(mappedMatrixIsReadOnly) {
+    test::TempFile file("mapped");
+    matrix::Matrix m = test::random(6, 4, 32);
+    matrix::writeBinary(m, file.path());
+    matrix::Matrix mapped = matrix::mapBinary(file.path(),
+        matrix::Access::Sequential);
+    CHECK(mapped.ReadOnly());
+    CHECK_THROWS(mapped[0][0] = 1.0);
+    CHECK(test::near(mapped * matrix::transposed(mapped),
+        test::reference(m, m.computeTransposed())));
+
+    // Resizing gives it a private buffer and leaves the file alone.
+    matrix::Matrix copy(mapped);
+    mapped.resize(2, 2);
+    mapped[0][0] = 5.0;
+    CHECK(test::near(matrix::readBinary(file.path()), copy, 0));
+}
+
+TEST(createBinaryIsZeroFilled) {
+    test::TempFile file("zeros");
+    matrix::createBinary(file.path(), 5, 3);
+    CHECK(test::near(matrix::readBinary(file.path()), matrix::Matrix(5, 3),
+        0));
+}
+
+TEST(binaryRejectsCorruptHeaders) {
+    test::TempFile file("corrupt");
+    matrix::Matrix m = test::random(4, 4, 33);
+    const size_t rows = offsetof(matrix::__m_file_header, rows);
+    const size_t cols = offsetof(matrix::__m_file_header, cols);
+    const size_t alignment = offsetof(matrix::__m_file_header, alignment);
+    const size_t offset = offsetof(matrix::__m_file_header, dataOffset);
+
+    writeFile(file.path(), "not a matrix file at all, but long enough for "
+        "a whole header to be read");
+    CHECK_THROWS(matrix::readHeader(file.path()));
+    writeFile(file.path(), "MTRX");
+    CHECK_THROWS(matrix::readBinary(file.path()));
+
+    matrix::writeBinary(m, file.path());
+    patch(file.path(), rows, 5);
+    CHECK_THROWS(matrix::readBinary(file.path()));
+    CHECK_THROWS(matrix::mapBinary(file.path()));
+
+    matrix::writeBinary(m, file.path());
+    uint64_t page = matrix::readHeader(file.path()).dataOffset;
+    patch(file.path(), offset, page + 4);
+    CHECK_THROWS(matrix::readBinary(file.path()));
+    CHECK_THROWS(matrix::mapBinary(file.path()));
+    patch(file.path(), alignment, 4);
+    CHECK_THROWS(matrix::mapBinary(file.path()));
+    patch(file.path(), alignment, 0);
+    CHECK_THROWS(matrix::readHeader(file.path()));
+
+    // rows * cols * 8 wraps around to a small size.
+    matrix::writeBinary(m, file.path());
+    patch(file.path(), rows, uint64_t(1) << 32);
+    patch(file.path(), cols, uint64_t(1) << 29);
+    CHECK_THROWS(matrix::readBinary(file.path()));
+    CHECK_THROWS(matrix::mapBinary(file.path()));
+    patch(file.path(), rows, std::numeric_limits<uint64_t>::max());
+    patch(file.path(), cols, 2);
+    CHECK_THROWS(matrix::readHeader(file.path()));
+}
+
+TEST(textRoundTrip) {
+    test::TempFile file("text");
+    for (size_t rows : {0, 1, 17}) {
+        for (size_t cols : {0, 1, 23}) {
+            matrix::Matrix m = test::random(rows, cols, 34, 3);
+            matrix::writeText(m, file.path());
+            matrix::Matrix back = matrix::readText(file.path(), 3);
+            CHECK(back.Rows() == rows && back.Cols() == cols);
+            CHECK(test::near(back, m, 0));
+        }
+    }
+}
+
+TEST(textAcceptsLooseSpacing) {
+    test::TempFile file("loose");
+    writeFile(file.path(), "2 3 \r\n  1\t2   3\r\n4 5 6");
+    matrix::Matrix m = matrix::readText(file.path());
+    CHECK(m.Rows() == 2 && m.Cols() == 3);
+    CHECK(test::same(m[0][2], 3.0) && test::same(m[1][0], 4.0));
+    writeFile(file.path(), "1 2\n1 2\n\n\n");
+    CHECK(matrix::readText(file.path()).Rows() == 1);
+}
+
+TEST(textRejectsMalformedRows) {
+    test::TempFile file("malformed");
+    const char* bad[] = {
+        "",
+        "2",
+        "x 2\n1 2\n",
+        "1 2 junk\n1 2\n",
+        "2 2\n1 2 3\n4\n",
+        "2 2\n1\n2 3 4\n",
+        "2 2\n1 2\n3\n4\n",
+        "2 2\n1 2\n",
+        "2 2\n1 2\n3 x\n",
+        "2 2\n1 2\n3 4\n5 6\n",
+        "1000000000 1000000000\n1\n",
+    };
+    for (const char* text : bad) {
+        writeFile(file.path(), text);
+        CHECK_THROWS(matrix::readText(file.path(), 2));
+    }
+    CHECK_THROWS(matrix::readText(file.path() + ".missing"));
+}
+
+// A short row must not borrow numbers from the next one, whatever
+// whitespace ends it.
+TEST(textRejectsShortRows) {
+    test::TempFile file("short");
+    const char* bad[] = {
+        "2 2\n1\n2 3\n",
+        "2 2\n1\f\n2 3\n",
+        "2 2\n1 \v\n2 3\n",
+        "2 2\n1\v\n2\n",
+        "1 2\n1\f\n",
+        "1 2\n\f1\n",
+    };
+    for (const char* text : bad) {
+        writeFile(file.path(), text);
+        CHECK_THROWS(matrix::readText(file.path()));
+    }
+}
@@ -0,0 +1,50 @@
+#include "Test.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "Numa.hpp"
+#include "ThreadPool.hpp"
+
+TEST(numaTopologyIsConsistent) {
+    size_t nodes = matrix::numa::nodeCount();
+    CHECK(nodes >= 1);
+    std::vector<int> online = matrix::numa::onlineNodes();
+    CHECK(!online.empty() && std::is_sorted(online.begin(), online.end()));
+    CHECK(online.size() >= nodes);
+    std::vector<int> cpus = matrix::numa::placementCpus();
+    CHECK(!cpus.empty());
+    std::vector<int> sorted(cpus);
+    std::sort(sorted.begin(), sorted.end());
+    CHECK(std::unique(sorted.begin(), sorted.end()) == sorted.end());
+    // Each node's CPUs form one run.
+    std::vector<int> seen;
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        int node = matrix::numa::nodeOfCpu(cpus[i]);
+        if (i == 0 || node != matrix::numa::nodeOfCpu(cpus[i - 1])) {
+            CHECK(std::find(seen.begin(), seen.end(), node) == seen.end());
+            seen.push_back(node);
+        }
+    }
+}
+
+TEST(rowNodesOfLargeMatrix) {
+    // Over the first-touch threshold, so rows are touched by the workers.
+    matrix::Matrix m(512, 512, matrix::ThreadPool::shared().Size());
+    std::vector<int> nodes = m.rowNodes();
+    CHECK(nodes.size() == 512);
+    // Node IDs can be sparse, so check them against the online ones.
+    std::vector<int> online = matrix::numa::onlineNodes();
+    for (int node : nodes) {
+        CHECK(node == -1 ||
+            std::find(online.begin(), online.end(), node) != online.end());
+    }
+    CHECK(matrix::Matrix(0, 4).rowNodes().empty());
+
+    // Products into a fresh matrix give the same values whatever the
+    // placement.
+    matrix::Matrix a = test::random(300, 200, 81, 4);
+    matrix::Matrix b = test::random(200, 300, 82, 4);
+    CHECK(test::near(a * b, test::reference(a, b)));
+}
@@ -0,0 +1,42 @@
+#include "Test.hpp"
+
+#include "Elementwise.hpp"
+#include "Matrix.hpp"
+
+TEST(powMatchesRepeatedProducts) {
+    matrix::Matrix base = test::random(7, 7, 1, 3);
+    matrix::Matrix expected = matrix::Matrix::Identity(7);
+    for (size_t k = 0; k <= 13; ++k) {
+        CHECK(test::near(matrix::pow(base, k), expected, 1e-12));
+        expected = test::reference(expected, base);
+    }
+}
+
+TEST(powOfDiagonalAndIdentity) {
+    matrix::Matrix d(5, 5, 2);
+    for (size_t i = 0; i < 5; ++i) {
+        d[i][i] = 0.5 + static_cast<double>(i);
+    }
+    matrix::Matrix p = matrix::pow(d, 6);
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 5; ++j) {
+            double x = i == j ? std::pow(d[i][i], 6) : 0.0;
+            CHECK(test::near(p[i][j], x, 1e-15));
+        }
+    }
+    CHECK(matrix::pow(matrix::Matrix::Identity(4), 100).isIdentity());
+}
+
+TEST(squareRepeatedMatchesPow) {
+    matrix::Matrix base = test::random(9, 9, 2, 2);
+    base *= 0.3;
+    CHECK(test::near(matrix::squareRepeated(base, 0), base, 0));
+    CHECK(test::near(matrix::squareRepeated(base, 3),
+        matrix::pow(base, 8), 1e-12));
+}
+
+TEST(powRejectsNonSquare) {
+    matrix::Matrix m(3, 4);
+    CHECK_THROWS(matrix::pow(m, 2));
+    CHECK_THROWS(matrix::squareRepeated(m, 2));
+}
@@ -0,0 +1,73 @@
+#include "Test.hpp"
+
+#include <unistd.h>
+
+#include <string>
+
+#include "Matrix.hpp"
+#include "MatrixIO.hpp"
+#include "Streaming.hpp"
+
+TEST(multiplyFilesMatchesReference) {
+    test::TempFile fa("stream_a");
+    test::TempFile fb("stream_b");
+    test::TempFile fc("stream_c");
+    matrix::Matrix a = test::random(23, 17, 41);
+    matrix::Matrix b = test::random(17, 31, 42);
+    matrix::writeBinary(a, fa.path());
+    matrix::writeBinary(b, fb.path());
+    matrix::Matrix expected = test::reference(a, b);
+
+    // From blocks of one element, through ragged edges in every dimension,
+    // to everything in one block.
+    for (size_t s : {1, 4, 7, 16, 64}) {
+        for (size_t threads : {1, 3}) {
+            matrix::multiplyFiles(fa.path(), fb.path(), fc.path(),
+                6 * sizeof(double) * s * s, threads);
+            CHECK(test::near(matrix::readBinary(fc.path()), expected));
+        }
+    }
+}
+
+TEST(multiplyFilesDegenerateShapes) {
+    test::TempFile fa("stream_a");
+    test::TempFile fb("stream_b");
+    test::TempFile fc("stream_c");
+    matrix::writeBinary(matrix::Matrix(3, 0), fa.path());
+    matrix::writeBinary(matrix::Matrix(0, 4), fb.path());
+    matrix::multiplyFiles(fa.path(), fb.path(), fc.path(), 1 << 20);
+    CHECK(test::near(matrix::readBinary(fc.path()), matrix::Matrix(3, 4), 0));
+
+    matrix::writeBinary(matrix::Matrix(0, 5), fa.path());
+    matrix::writeBinary(matrix::Matrix(5, 2), fb.path());
+    matrix::multiplyFiles(fa.path(), fb.path(), fc.path(), 1 << 20);
+    CHECK(matrix::readHeader(fc.path()).rows == 0);
+}
+
+TEST(multiplyFilesRejectsBadArguments) {
+    test::TempFile fa("stream_a");
+    test::TempFile fb("stream_b");
+    test::TempFile fc("stream_c");
+    test::TempFile link("stream_link");
+    matrix::Matrix a = test::random(4, 4, 43);
+    matrix::writeBinary(a, fa.path());
+    matrix::writeBinary(matrix::Matrix(3, 2), fb.path());
+    CHECK_THROWS(matrix::multiplyFiles(fa.path(), fb.path(), fc.path(),
+        1 << 20));
+
+    matrix::writeBinary(a, fb.path());
+    CHECK_THROWS(matrix::multiplyFiles(fa.path(), fb.path(), fc.path(), 8));
+
+    // The output naming an input, directly or through another path, must
+    // leave the input intact.
+    CHECK(::link(fa.path().c_str(), link.path().c_str()) == 0);
+    CHECK_THROWS(matrix::multiplyFiles(fa.path(), fb.path(), fa.path(),
+        1 << 20));
+    CHECK_THROWS(matrix::multiplyFiles(fa.path(), fb.path(), link.path(),
+        1 << 20));
+    CHECK_THROWS(matrix::multiplyFiles(fb.path(), fa.path(),
+        fa.path().substr(0, fa.path().rfind('/')) + "/." +
+            fa.path().substr(fa.path().rfind('/')),
+        1 << 20));
+    CHECK(test::near(matrix::readBinary(fa.path()), a, 0));
+}
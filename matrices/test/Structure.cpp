@@ -0,0 +1,146 @@
+#include "Test.hpp"
+
+#include <vector>
+
+#include "Matrix.hpp"
+
+// An n x n matrix of the given kind with random entries inside its band.
+// General ones are rows x cols.
+static matrix::Matrix make(matrix::Structure kind, size_t rows, size_t cols,
+        size_t lower, size_t upper, unsigned seed) {
+    matrix::Matrix m = test::random(rows, cols, seed, 3);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            bool keep = true;
+            switch (kind) {
+                case matrix::Structure::General: break;
+                case matrix::Structure::Identity:
+                    m[i][j] = i == j ? 1.0 : 0.0;
+                    break;
+                case matrix::Structure::Diagonal: keep = i == j; break;
+                case matrix::Structure::UpperTriangular: keep = j >= i; break;
+                case matrix::Structure::LowerTriangular: keep = j <= i; break;
+                case matrix::Structure::Banded:
+                    keep = j + lower >= i && j <= i + upper;
+                    break;
+            }
+            if (!keep) {
+                m[i][j] = 0.0;
+            }
+        }
+    }
+    return m;
+}
+
+// The dense kernel on the same values.
+static matrix::Matrix dense(const matrix::Matrix& left,
+        const matrix::Matrix& right) {
+    matrix::Matrix l(left);
+    matrix::Matrix r(right);
+    l.setStructure(matrix::Structure::General);
+    r.setStructure(matrix::Structure::General);
+    return l * r;
+}
+
+static bool identical(const matrix::Matrix& a, const matrix::Matrix& b) {
+    return test::near(a, b, 0);
+}
+
+TEST(structureDetection) {
+    size_t n = 40;
+    CHECK(make(matrix::Structure::Identity, n, n, 0, 0, 1).structure() ==
+        matrix::Structure::Identity);
+    CHECK(make(matrix::Structure::Diagonal, n, n, 0, 0, 1).structure() ==
+        matrix::Structure::Diagonal);
+    CHECK(make(matrix::Structure::UpperTriangular, n, n, 0, 0, 1)
+        .structure() == matrix::Structure::UpperTriangular);
+    CHECK(make(matrix::Structure::LowerTriangular, n, n, 0, 0, 1)
+        .structure() == matrix::Structure::LowerTriangular);
+    matrix::Matrix band = make(matrix::Structure::Banded, n, n, 2, 3, 1);
+    CHECK(band.structure() == matrix::Structure::Banded);
+    CHECK(band.LowerBandwidth() == 2 && band.UpperBandwidth() == 3);
+    CHECK(make(matrix::Structure::Banded, n, n, 10, 10, 1).structure() ==
+        matrix::Structure::General);
+    CHECK(test::random(n, n + 1, 1).structure() ==
+        matrix::Structure::General);
+
+    // Any mutable access forgets it.
+    band[0][n - 1] = 1.0;
+    CHECK(band.structure() == matrix::Structure::General);
+    CHECK_THROWS(test::random(3, 4, 1).setStructure(
+        matrix::Structure::Diagonal));
+}
+
+TEST(structuredProductsMatchDense) {
+    const matrix::Structure kinds[] = {
+        matrix::Structure::General,
+        matrix::Structure::Identity,
+        matrix::Structure::Diagonal,
+        matrix::Structure::UpperTriangular,
+        matrix::Structure::LowerTriangular,
+        matrix::Structure::Banded,
+    };
+    // Narrow bands go through the axpy kernel, wide ones through blocks
+    // of the GEMM kernel.
+    struct Case {
+        size_t n;
+        size_t lower;
+        size_t upper;
+    };
+    const Case cases[] = {{1, 0, 0}, {37, 1, 2}, {37, 4, 0}, {300, 40, 30},
+        {300, 70, 2}};
+    unsigned seed = 200;
+    for (const Case& c : cases) {
+        for (matrix::Structure ls : kinds) {
+            for (matrix::Structure rs : kinds) {
+                // General operands are rectangular where the other one
+                // allows it.
+                size_t m = ls == matrix::Structure::General ? c.n + 3 : c.n;
+                size_t n = rs == matrix::Structure::General ? c.n + 5 : c.n;
+                if (ls == matrix::Structure::General &&
+                        rs == matrix::Structure::General) {
+                    continue;
+                }
+                matrix::Matrix a = make(ls, m, c.n, c.lower, c.upper, ++seed);
+                matrix::Matrix b = make(rs, c.n, n, c.upper, c.lower, ++seed);
+                matrix::Matrix res(0);
+                CHECK(matrix::multiplyStructured(a, b, res));
+                CHECK(identical(res, dense(a, b)));
+                CHECK(identical(a * b, dense(a, b)));
+            }
+        }
+    }
+}
+
+TEST(taggedStructureIsTrusted) {
+    // A tag wider than the actual band is still exact; the caller only
+    // vouches that nothing lies outside it.
+    size_t n = 90;
+    matrix::Matrix a = make(matrix::Structure::Banded, n, n, 1, 1, 301);
+    matrix::Matrix b = test::random(n, 20, 302);
+    a.setStructure(matrix::Structure::Banded, 5, 9);
+    CHECK(identical(a * b, dense(a, b)));
+    matrix::Matrix lower = make(matrix::Structure::LowerTriangular, n, n, 0,
+        0, 303);
+    CHECK(identical(lower * b, dense(lower, b)));
+}
+
+TEST(writesThroughEarlierPointersAreSeen) {
+    // The pointer is taken before the structure is first looked at, so no
+    // mutable access follows the detection.
+    size_t n = 4;
+    matrix::Matrix m(n, n);
+    double* data = m.Data();
+    for (size_t i = 0; i < n; ++i) {
+        data[i * n + i] = 1.0;
+    }
+    matrix::Matrix b = test::random(n, n, 304);
+    CHECK(m.structure() == matrix::Structure::Identity);
+    CHECK(identical(m * b, b));
+    for (size_t i = 0; i < n * n; ++i) {
+        data[i] = 5.0;
+    }
+    CHECK(m.structure() == matrix::Structure::General);
+    CHECK(identical(m * b, dense(m, b)));
+    CHECK(test::near(m * b, test::reference(m, b)));
+}
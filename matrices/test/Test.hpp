@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Matrix.hpp"
+
+#ifndef MATRICES_TEST_TEST_HPP_
+#define MATRICES_TEST_TEST_HPP_
+
+namespace test {
+
+// Thrown by a failed CHECK; the runner reports it and goes on with the
+// next test.
+struct Failure {
+    const char* file;
+    int line;
+    const char* expression;
+};
+
+struct __case {
+    const char* name;
+    void (*run)(void);
+};
+
+std::vector<__case>& cases();
+
+struct __register {
+    __register(const char* name, void (*run)(void)) {
+        cases().push_back(__case{name, run});
+    }
+};
+
+// Exact comparison without tripping -Wfloat-equal.
+inline bool same(double a, double b) {
+    return std::equal_to<double>()(a, b);
+}
+
+inline bool near(double a, double b, double tolerance = 1e-9) {
+    return std::fabs(a - b) <= tolerance * std::max(1.0,
+        std::max(std::fabs(a), std::fabs(b)));
+}
+
+inline bool near(const matrix::Matrix& a, const matrix::Matrix& b,
+        double tolerance = 1e-9) {
+    if (a.Size() != b.Size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.Rows(); ++i) {
+        for (size_t j = 0; j < a.Cols(); ++j) {
+            if (!near(a[i][j], b[i][j], tolerance)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Deterministic entries in [-1, 1), different for every seed.
+matrix::Matrix random(size_t rows, size_t cols, unsigned seed,
+    size_t num_threads = 1);
+
+// A path in the temporary directory unique to this process; the file is
+// removed when the returned object goes away.
+class TempFile {
+    public:
+        explicit TempFile(const char* name);
+        ~TempFile();
+
+        TempFile(const TempFile& other) = delete;
+        TempFile& operator=(const TempFile& other) = delete;
+
+        const std::string& path() const { return path_; }
+
+    private:
+        std::string path_;
+};
+
+// The plain triple loop every kernel is checked against.
+matrix::Matrix reference(const matrix::Matrix& left,
+    const matrix::Matrix& right);
+
+}  // namespace test
+
+#define TEST(name) \
+    static void name(void); \
+    static test::__register name##_registered(#name, &name); \
+    static void name(void)
+
+#define CHECK(...) \
+    do { \
+        if (!(__VA_ARGS__)) { \
+            throw test::Failure{__FILE__, __LINE__, #__VA_ARGS__}; \
+        } \
+    } while (0)
+
+// The library reports misuse by throwing a message.
+#define CHECK_THROWS(...) \
+    do { \
+        bool thrown = false; \
+        try { \
+            __VA_ARGS__; \
+        } catch (const char*) { \
+            thrown = true; \
+        } \
+        if (!thrown) { \
+            throw test::Failure{__FILE__, __LINE__, #__VA_ARGS__ " throws"}; \
+        } \
+    } while (0)
+
+#endif  // MATRICES_TEST_TEST_HPP_
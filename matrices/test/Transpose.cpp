@@ -0,0 +1,56 @@
+#include "Test.hpp"
+
+#include "Matrix.hpp"
+
+static bool isTransposeOf(const matrix::Matrix& t, const matrix::Matrix& m) {
+    if (t.Rows() != m.Cols() || t.Cols() != m.Rows()) {
+        return false;
+    }
+    for (size_t i = 0; i < m.Rows(); ++i) {
+        for (size_t j = 0; j < m.Cols(); ++j) {
+            if (!test::same(t[j][i], m[i][j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TEST(computeTransposedRectangular) {
+    for (size_t rows : {1, 17, 300}) {
+        for (size_t cols : {1, 9, 257}) {
+            matrix::Matrix m = test::random(rows, cols, 11, 4);
+            CHECK(isTransposeOf(m.computeTransposed(), m));
+        }
+    }
+    matrix::Matrix empty(0, 5);
+    CHECK(empty.computeTransposed().Rows() == 5);
+    CHECK(empty.computeTransposed().Cols() == 0);
+}
+
+TEST(transposeInPlaceSquare) {
+    for (size_t n : {1, 2, 31, 130}) {
+        matrix::Matrix m = test::random(n, n, 12, 3);
+        matrix::Matrix t(m);
+        t.transposeInPlace();
+        CHECK(isTransposeOf(t, m));
+    }
+    matrix::Matrix m(3, 4);
+    CHECK_THROWS(m.transposeInPlace());
+}
+
+TEST(transposedViewProducts) {
+    matrix::Matrix a = test::random(23, 41, 13, 2);
+    matrix::Matrix b = test::random(37, 41, 14, 2);
+    matrix::Matrix c = test::random(23, 19, 15, 2);
+    CHECK(test::near(a * matrix::transposed(b),
+        test::reference(a, b.computeTransposed())));
+    CHECK(test::near(matrix::transposed(a) * c,
+        test::reference(a.computeTransposed(), c)));
+
+    matrix::Matrix res(0);
+    matrix::multiply(a, matrix::transposed(b), res);
+    CHECK(res.Rows() == 23 && res.Cols() == 37);
+    CHECK_THROWS(a * matrix::transposed(c));
+    CHECK_THROWS(matrix::multiply(a, matrix::transposed(a), a));
+}
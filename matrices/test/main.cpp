@@ -0,0 +1,81 @@
+#include <unistd.h>
+
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "Test.hpp"
+
+namespace test {
+
+std::vector<__case>& cases() {
+    static std::vector<__case> all;
+    return all;
+}
+
+TempFile::TempFile(const char* name) :
+    path_((std::filesystem::temp_directory_path() / ("matrices_test_" +
+        std::to_string(::getpid()) + "_" + name)).string()) {}
+
+TempFile::~TempFile() {
+    std::remove(path_.c_str());
+}
+
+matrix::Matrix random(size_t rows, size_t cols, unsigned seed,
+        size_t num_threads) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    matrix::Matrix res(rows, cols, num_threads);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            res[i][j] = dist(gen);
+        }
+    }
+    return res;
+}
+
+matrix::Matrix reference(const matrix::Matrix& left,
+        const matrix::Matrix& right) {
+    matrix::Matrix res(left.Rows(), right.Cols());
+    for (size_t i = 0; i < left.Rows(); ++i) {
+        for (size_t j = 0; j < right.Cols(); ++j) {
+            double acc = 0.0;
+            for (size_t p = 0; p < left.Cols(); ++p) {
+                acc += left[i][p] * right[p][j];
+            }
+            res[i][j] = acc;
+        }
+    }
+    return res;
+}
+
+}  // namespace test
+
+int main(int argc, char *argv[]) {
+    size_t failed = 0;
+    for (const test::__case& c : test::cases()) {
+        if (argc > 1 && std::string(argv[1]) != c.name) {
+            continue;
+        }
+        try {
+            c.run();
+            std::cout << "ok   " << c.name << std::endl;
+            continue;
+        } catch (const test::Failure& f) {
+            std::cout << "FAIL " << c.name << ": " << f.file << ":" << f.line
+                << ": " << f.expression << std::endl;
+        } catch (const char* what) {
+            std::cout << "FAIL " << c.name << ": threw " << what << std::endl;
+        } catch (const std::exception& e) {
+            std::cout << "FAIL " << c.name << ": threw " << e.what()
+                << std::endl;
+        }
+        ++failed;
+    }
+    std::cout << test::cases().size() << " tests, " << failed << " failed"
+        << std::endl;
+    return failed == 0 ? 0 : 1;
+}